@@ -0,0 +1,128 @@
+#include "channel_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CHANNEL_STATS_SSE2
+#include <emmintrin.h>
+#endif
+
+double ChannelStats::rms() const
+{
+    return count == 0 ? 0.0 : std::sqrt(sum_squares / count);
+}
+
+void ChannelStats::merge(const ChannelStats& other)
+{
+    if (other.count == 0)
+        return;
+    if (count == 0)
+    {
+        *this = other;
+        return;
+    }
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    sum += other.sum;
+    sum_squares += other.sum_squares;
+    clipped += other.clipped;
+    count += other.count;
+}
+
+ClipRange clipRange(PcmFormat format)
+{
+    //Integer samples keep their raw value, so full scale is the largest value the container holds. Large 32-bit
+    //values round to 2^31 as floats, anything that close to full scale counts as clipped.
+    switch (format)
+    {
+        case PcmFormat::UInt8: return { -128.0f, 127.0f };
+        case PcmFormat::Int16: return { -32768.0f, 32767.0f };
+        case PcmFormat::Int24: return { -8388608.0f, 8388607.0f };
+        case PcmFormat::Int32: return { -2147483648.0f, 2147483648.0f };
+        default: return { -1.0f, 1.0f };
+    }
+}
+
+static void accumulateScalar(const float* samples, size_t n, const ClipRange& clip, float& lo, float& hi,
+                             double& sum, double& squares, unsigned long long& clipped)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        float x = samples[i];
+        lo = std::min(lo, x);
+        hi = std::max(hi, x);
+        sum += x;
+        squares += static_cast<double>(x) * x;
+        clipped += (x <= clip.low || x >= clip.high) ? 1 : 0;
+    }
+}
+
+void accumulateStats(const float* samples, size_t n, const ClipRange& clip, ChannelStats& stats)
+{
+    if (n == 0)
+        return;
+    float lo = samples[0];
+    float hi = samples[0];
+    double sum = 0.0;
+    double squares = 0.0;
+    unsigned long long clipped = 0;
+    size_t i = 0;
+
+#ifdef CHANNEL_STATS_SSE2
+    //Four lanes of min/max and clip counts, sums in double two lanes at a time. The 32-bit clip counters are
+    //folded every block so they cannot overflow however long the run is.
+    const size_t blockSize = 1 << 20;
+    __m128 vlo = _mm_set1_ps(lo);
+    __m128 vhi = _mm_set1_ps(hi);
+    __m128d vsum = _mm_setzero_pd();
+    __m128d vsquares = _mm_setzero_pd();
+    const __m128 clipLow = _mm_set1_ps(clip.low);
+    const __m128 clipHigh = _mm_set1_ps(clip.high);
+    while (i + 4 <= n)
+    {
+        size_t blockEnd = std::min(n & ~static_cast<size_t>(3), i + blockSize);
+        __m128i vclipped = _mm_setzero_si128();
+        for (; i < blockEnd; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(samples + i);
+            vlo = _mm_min_ps(vlo, x);
+            vhi = _mm_max_ps(vhi, x);
+            __m128d low = _mm_cvtps_pd(x);
+            __m128d high = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+            vsum = _mm_add_pd(vsum, _mm_add_pd(low, high));
+            vsquares = _mm_add_pd(vsquares, _mm_add_pd(_mm_mul_pd(low, low), _mm_mul_pd(high, high)));
+            //Compare masks are all ones (-1) per clipped lane
+            __m128 outside = _mm_or_ps(_mm_cmple_ps(x, clipLow), _mm_cmpge_ps(x, clipHigh));
+            vclipped = _mm_sub_epi32(vclipped, _mm_castps_si128(outside));
+        }
+        alignas(16) unsigned int lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), vclipped);
+        clipped += static_cast<unsigned long long>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    alignas(16) float lows[4];
+    alignas(16) float highs[4];
+    alignas(16) double sums[2];
+    alignas(16) double squareSums[2];
+    _mm_store_ps(lows, vlo);
+    _mm_store_ps(highs, vhi);
+    _mm_store_pd(sums, vsum);
+    _mm_store_pd(squareSums, vsquares);
+    lo = std::min(std::min(lows[0], lows[1]), std::min(lows[2], lows[3]));
+    hi = std::max(std::max(highs[0], highs[1]), std::max(highs[2], highs[3]));
+    sum = sums[0] + sums[1];
+    squares = squareSums[0] + squareSums[1];
+#endif
+
+    accumulateScalar(samples + i, n - i, clip, lo, hi, sum, squares, clipped);
+
+    ChannelStats run;
+    run.min = lo;
+    run.max = hi;
+    run.sum = sum;
+    run.sum_squares = squares;
+    run.clipped = clipped;
+    run.count = n;
+    stats.merge(run);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "pcm_decode.h"
+#include <cstddef>
+
+//Whole-channel statistics, gathered while the samples are decoded so nothing has to walk a channel again to find
+//its peak. Each decode slice accumulates its own ChannelStats, the slices are then merged. Values are in the raw
+//sample units the decoders produce (e.g. -32768..32767 for 16-bit files).
+struct ChannelStats {
+    float min = 0.0f;
+    float max = 0.0f;
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    unsigned long long clipped = 0;     //Samples at or beyond full scale
+    unsigned long long count = 0;
+
+    //Largest magnitude
+    float peak() const { return (-min > max) ? -min : max; }
+    double rms() const;
+    //Mean value, the offset of the waveform from zero
+    double dcOffset() const { return count == 0 ? 0.0 : sum / count; }
+
+    //Fold in the statistics of other samples of the same channel
+    void merge(const ChannelStats& other);
+};
+
+//Sample values that count as clipped for "format": at or below low, or at or above high
+struct ClipRange {
+    float low;
+    float high;
+};
+ClipRange clipRange(PcmFormat format);
+
+//Add samples[0, n) to "stats". Runs four samples at a time with SSE2 where available.
+void accumulateStats(const float* samples, size_t n, const ClipRange& clip, ChannelStats& stats);
@@ -0,0 +1,62 @@
+#include "frame_scheduler.h"
+#include "libs/glfw/include/GLFW/glfw3.h"
+
+#include <algorithm>
+
+void FrameScheduler::attach(GLFWwindow* window)
+{
+    glfwSetWindowUserPointer(window, this);
+
+    //Input. ImGui's backend installs its own callbacks later and calls these first.
+    glfwSetCursorPosCallback(window, [](GLFWwindow* w, double, double) { markInput(w); });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow* w, int) { markInput(w); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int, int, int) { markInput(w); });
+    glfwSetScrollCallback(window, [](GLFWwindow* w, double, double) { markInput(w); });
+    glfwSetKeyCallback(window, [](GLFWwindow* w, int, int, int, int) { markInput(w); });
+    glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int) { markInput(w); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow* w, int) { markInput(w); });
+
+    //The window itself changed or was uncovered
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* w, int, int) { markInput(w); });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) { markInput(w); });
+}
+
+void FrameScheduler::markInput(GLFWwindow* window)
+{
+    FrameScheduler* scheduler = static_cast<FrameScheduler*>(glfwGetWindowUserPointer(window));
+    if (scheduler != nullptr)
+        scheduler->settle_until = glfwGetTime() + settleSeconds;
+}
+
+void FrameScheduler::invalidate()
+{
+    dirty = true;
+}
+
+void FrameScheduler::requestFrameWithin(double seconds)
+{
+    if (next_frame_within <= 0.0 || seconds < next_frame_within)
+        next_frame_within = seconds;
+}
+
+void FrameScheduler::waitForNextFrame()
+{
+    frames_drawn++;
+
+    //Right after input (or a change) keep drawing at the display rate, vsync paces the loop
+    if (dirty || glfwGetTime() < settle_until)
+    {
+        dirty = false;
+        glfwPollEvents();
+    }
+    //Otherwise sleep until an event arrives, a requested frame is due or the idle timeout passes. Every wakeup
+    //draws one frame, and one caused by input starts a new settle period through the callbacks.
+    else
+    {
+        double timeout = idleSeconds;
+        if (next_frame_within > 0.0)
+            timeout = std::min(timeout, next_frame_within);
+        glfwWaitEventsTimeout(timeout);
+    }
+    next_frame_within = 0.0;
+}
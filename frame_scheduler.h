@@ -0,0 +1,40 @@
+#pragma once
+
+struct GLFWwindow;
+
+//Decides when the main loop draws. Instead of repainting every vsync the loop sleeps in glfwWaitEventsTimeout()
+//until input arrives, the window is resized or exposed, or something asked for a frame. After input it keeps
+//drawing for a short while so ImGui can finish hover delays and focus changes, then goes idle again. An idle
+//viewer wakes up about once a second.
+class FrameScheduler {
+public:
+    //How long to keep drawing after the last input
+    static constexpr double settleSeconds = 0.5;
+    //Longest sleep while nothing is happening
+    static constexpr double idleSeconds = 1.0;
+
+    //Install the callbacks that notice input and window changes. Must run before ImGui_ImplGlfw_InitForOpenGL()
+    //so the backend chains to them.
+    void attach(GLFWwindow* window);
+
+    //Something visible changed (new data, a finished load), draw the next frame right away
+    void invalidate();
+    //Draw again within "seconds" even without input, for progress bars and polling. Only holds for the next wait,
+    //so ask again every frame for as long as it is needed.
+    void requestFrameWithin(double seconds);
+
+    //Call after presenting a frame, in place of glfwPollEvents(). Returns once the next frame should be drawn.
+    void waitForNextFrame();
+
+    //Frames drawn since attach()
+    unsigned long long framesDrawn() const { return frames_drawn; }
+
+private:
+    //Reached from the GLFW callbacks through the window user pointer
+    static void markInput(GLFWwindow* window);
+
+    double settle_until = 0.0;
+    double next_frame_within = 0.0;
+    bool dirty = true;
+    unsigned long long frames_drawn = 0;
+};
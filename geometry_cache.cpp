@@ -0,0 +1,89 @@
+#include "geometry_cache.h"
+
+#include <cstring>
+
+bool GeometryCache::Key::operator==(const Key& other) const
+{
+    return data_version == other.data_version && view_min == other.view_min && view_max == other.view_max &&
+           plot_pos.x == other.plot_pos.x && plot_pos.y == other.plot_pos.y &&
+           plot_size.x == other.plot_size.x && plot_size.y == other.plot_size.y && scale == other.scale;
+}
+
+//Start a new vertex range so the next vertex is index 0 of its draw command, then cached indices can be copied
+//as they are. Only possible when the renderer honours ImDrawCmd::VtxOffset.
+static bool restartVertexRange(ImDrawList* drawList)
+{
+    if (!(drawList->Flags & ImDrawListFlags_AllowVtxOffset))
+        return false;
+    if (drawList->_VtxCurrentIdx != 0)
+    {
+        drawList->_CmdHeader.VtxOffset = drawList->VtxBuffer.Size;
+        drawList->_OnChangedVtxOffset();
+    }
+    return true;
+}
+
+bool GeometryCache::draw(ImDrawList* drawList, const Key& key) const
+{
+    if (!valid || !(cached_key == key))
+        return false;
+    if (vertices.Size == 0)
+        return true;
+
+    //Without vertex offsets the indices are rebased one by one, as long as they still fit ImDrawIdx
+    bool rebase = !restartVertexRange(drawList);
+    unsigned int base = drawList->_VtxCurrentIdx;
+    if (rebase && sizeof(ImDrawIdx) == 2 && base + vertices.Size >= (1u << 16))
+        return false;
+
+    drawList->PrimReserve(indices.Size, vertices.Size);
+    std::memcpy(drawList->_VtxWritePtr, vertices.Data, vertices.Size * sizeof(ImDrawVert));
+    if (!rebase)
+    {
+        std::memcpy(drawList->_IdxWritePtr, indices.Data, indices.Size * sizeof(ImDrawIdx));
+    }
+    else
+    {
+        for (int i = 0; i < indices.Size; i++)
+            drawList->_IdxWritePtr[i] = static_cast<ImDrawIdx>(indices.Data[i] + base);
+    }
+    drawList->_VtxWritePtr += vertices.Size;
+    drawList->_IdxWritePtr += indices.Size;
+    drawList->_VtxCurrentIdx += vertices.Size;
+    return true;
+}
+
+void GeometryCache::beginRecording(ImDrawList* drawList)
+{
+    restartVertexRange(drawList);
+    first_vertex = drawList->VtxBuffer.Size;
+    first_index = drawList->IdxBuffer.Size;
+    first_vertex_index = drawList->_VtxCurrentIdx;
+    vtx_offset = drawList->_CmdHeader.VtxOffset;
+}
+
+void GeometryCache::endRecording(ImDrawList* drawList, const Key& key)
+{
+    //A 16-bit draw list that ran out of indices split the geometry over two vertex ranges, leave that uncached
+    valid = false;
+    if (drawList->_CmdHeader.VtxOffset != vtx_offset)
+        return;
+
+    int vertexCount = drawList->VtxBuffer.Size - first_vertex;
+    int indexCount = drawList->IdxBuffer.Size - first_index;
+    vertices.resize(vertexCount);
+    indices.resize(indexCount);
+    if (vertexCount > 0)
+        std::memcpy(vertices.Data, drawList->VtxBuffer.Data + first_vertex, vertexCount * sizeof(ImDrawVert));
+    for (int i = 0; i < indexCount; i++)
+        indices.Data[i] = static_cast<ImDrawIdx>(drawList->IdxBuffer.Data[first_index + i] - first_vertex_index);
+    cached_key = key;
+    valid = true;
+}
+
+void GeometryCache::clear()
+{
+    valid = false;
+    vertices.clear();
+    indices.clear();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "imgui.h"
+#include <cstddef>
+
+//Vertices and indices of something drawn into an ImDrawList, kept together with what they were drawn for. When a
+//later frame draws the same thing again they are copied into the draw list with one PrimReserve() and a memcpy
+//each instead of being generated again, so an unchanged waveform costs the same however many points it has.
+class GeometryCache {
+public:
+    //Everything the geometry depends on. Any difference means it has to be built again.
+    struct Key {
+        unsigned long long data_version = 0;
+        double view_min = 0.0;             //Visible range of the time axis
+        double view_max = 0.0;
+        ImVec2 plot_pos;
+        ImVec2 plot_size;
+        float scale = 0.0f;
+
+        bool operator==(const Key& other) const;
+    };
+
+    //Copy the cached geometry into "drawList" if it was built for "key". Returns false when it was not, the caller
+    //then draws as usual between beginRecording() and endRecording().
+    bool draw(ImDrawList* drawList, const Key& key) const;
+
+    //Capture every vertex and index added to "drawList" from here to endRecording() as the geometry for "key"
+    void beginRecording(ImDrawList* drawList);
+    void endRecording(ImDrawList* drawList, const Key& key);
+
+    void clear();
+    int vertexCount() const { return vertices.Size; }
+
+private:
+    Key cached_key;
+    bool valid = false;
+    ImVector<ImDrawVert> vertices;
+    ImVector<ImDrawIdx> indices;    //Relative to the first cached vertex
+
+    //Where the recording started
+    int first_vertex = 0;
+    int first_index = 0;
+    unsigned int first_vertex_index = 0;
+    unsigned int vtx_offset = 0;
+};
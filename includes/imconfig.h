@@ -106,7 +106,12 @@
 // Your renderer backend will need to support it (most example renderer backends support both 16/32-bit indices).
 // Another way to allow large meshes while keeping 16-bit indices is to handle ImDrawCmd::VtxOffset in your renderer.
 // Read about ImGuiBackendFlags_RendererHasVtxOffset for details.
-//#define ImDrawIdx unsigned int
+// Waveform Visualizer: a dense waveform is one large mesh per channel. With 32-bit indices ImPlot can emit it as a
+// single draw command instead of starting a new one every 64K vertices. The OpenGL3 backend supports both sizes,
+// define IMGUI_USE_16BIT_INDICES in the project to go back to 16-bit.
+#ifndef IMGUI_USE_16BIT_INDICES
+#define ImDrawIdx unsigned int
+#endif
 
 //---- Override ImDrawCallback signature (will need to modify renderer backends accordingly)
 //struct ImDrawList;
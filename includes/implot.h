@@ -90,6 +90,7 @@ typedef int ImPlotLineFlags;          // -> ImPlotLineFlags_
 typedef int ImPlotScatterFlags;       // -> ImPlotScatterFlags
 typedef int ImPlotStairsFlags;        // -> ImPlotStairsFlags_
 typedef int ImPlotShadedFlags;        // -> ImPlotShadedFlags_
+typedef int ImPlotWaveformFlags;      // -> ImPlotWaveformFlags_
 typedef int ImPlotBarsFlags;          // -> ImPlotBarsFlags_
 typedef int ImPlotBarGroupsFlags;     // -> ImPlotBarGroupsFlags_
 typedef int ImPlotErrorBarsFlags;     // -> ImPlotErrorBarsFlags_
@@ -253,6 +254,11 @@ enum ImPlotShadedFlags_ {
     ImPlotShadedFlags_None  = 0 // default
 };
 
+// Flags for PlotWaveform (placeholder)
+enum ImPlotWaveformFlags_ {
+    ImPlotWaveformFlags_None = 0 // default
+};
+
 // Flags for PlotBars
 enum ImPlotBarsFlags_ {
     ImPlotBarsFlags_None         = 0,       // default
@@ -873,6 +879,10 @@ IMPLOT_TMP void PlotShaded(const char* label_id, const T* xs, const T* ys, int c
 IMPLOT_TMP void PlotShaded(const char* label_id, const T* xs, const T* ys1, const T* ys2, int count, ImPlotShadedFlags flags=0, int offset=0, int stride=sizeof(T));
 IMPLOT_API void PlotShadedG(const char* label_id, ImPlotGetter getter1, void* data1, ImPlotGetter getter2, void* data2, int count, ImPlotShadedFlags flags=0);
 
+// Plots the envelope of a dense signal already reduced to a minimum and maximum per column, e.g. one column per pixel. Columns a couple of pixels apart or closer are each rendered as one vertical min-to-max quad stretched to meet its neighbour, so a column costs 4 vertices. Sparser columns are joined by a line through their minima and maxima.
+IMPLOT_TMP void PlotWaveform(const char* label_id, const T* mins, const T* maxs, int count, double xscale=1, double xstart=0, ImPlotWaveformFlags flags=0, int offset=0, int stride=sizeof(T));
+IMPLOT_API void PlotWaveformG(const char* label_id, ImPlotGetter getter_min, void* data_min, ImPlotGetter getter_max, void* data_max, int count, ImPlotWaveformFlags flags=0);
+
 // Plots a bar graph. Vertical by default. #bar_size and #shift are in plot units.
 IMPLOT_TMP void PlotBars(const char* label_id, const T* values, int count, double bar_size=0.67, double shift=0, ImPlotBarsFlags flags=0, int offset=0, int stride=sizeof(T));
 IMPLOT_TMP void PlotBars(const char* label_id, const T* xs, const T* ys, int count, double bar_size, ImPlotBarsFlags flags=0, int offset=0, int stride=sizeof(T));
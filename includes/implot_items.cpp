@@ -618,6 +618,19 @@ struct GetterLoop {
     const int Count;
 };
 
+/// Interleaves the points of two getters column by column as a zig-zag: min, max of even columns and max, min of odd ones
+template <typename _Getter1, typename _Getter2>
+struct GetterZigZag {
+    GetterZigZag(const _Getter1& getter1, const _Getter2& getter2) : Getter1(getter1), Getter2(getter2), Count(ImMin(getter1.Count, getter2.Count) * 2) { }
+    template <typename I> IMPLOT_INLINE ImPlotPoint operator()(I idx) const {
+        const I column = idx / 2;
+        return ((idx ^ column) & 1) == 0 ? Getter1(column) : Getter2(column);
+    }
+    const _Getter1 Getter1;
+    const _Getter2 Getter2;
+    const int Count;
+};
+
 template <typename T>
 struct GetterError {
     GetterError(const T* xs, const T* ys, const T* neg, const T* pos, int count, int offset, int stride) :
@@ -1324,6 +1337,64 @@ struct RendererShaded : RendererBase {
     mutable ImVec2 UV;
 };
 
+template <class _Getter1, class _Getter2>
+struct RendererWaveformBars : RendererBase {
+    RendererWaveformBars(const _Getter1& getter1, const _Getter2& getter2, ImU32 col, float weight) :
+        RendererBase(ImMin(getter1.Count, getter2.Count), 6, 4),
+        Getter1(getter1),
+        Getter2(getter2),
+        Col(col),
+        HalfWeight(ImMax(1.0f,weight)*0.5f)
+    {
+        P1 = this->Transformer(Getter1(0));
+        Width = 2 * HalfWeight;
+        PrevTop = PrevBottom = P1.y;
+    }
+    void Init(ImDrawList& draw_list) const {
+        UV = draw_list._Data->TexUvWhitePixel;
+    }
+    IMPLOT_INLINE bool Render(ImDrawList& draw_list, const ImRect& cull_rect, int prim) const {
+        const ImVec2 PMin = P1;
+        const ImVec2 PMax = this->Transformer(Getter2(prim));
+        // each column reaches to the left edge of the next one
+        if (prim + 1 < Prims) {
+            P1 = this->Transformer(Getter1(prim + 1));
+            Width = P1.x - PMin.x;
+        }
+        float top    = ImMin(PMin.y, PMax.y);
+        float bottom = ImMax(PMin.y, PMax.y);
+        // stretch over the gap to the previous column so the columns join up like a line would
+        const float col_top = top;
+        const float col_bottom = bottom;
+        if (prim > 0) {
+            top    = ImMin(top, PrevBottom);
+            bottom = ImMax(bottom, PrevTop);
+        }
+        PrevTop = col_top;
+        PrevBottom = col_bottom;
+        if (bottom - top < 2 * HalfWeight) {
+            const float mid = (top + bottom) * 0.5f;
+            top = mid - HalfWeight;
+            bottom = mid + HalfWeight;
+        }
+        const ImVec2 Rmin(ImMin(PMin.x, PMin.x + Width), top);
+        const ImVec2 Rmax(ImMax(PMin.x, PMin.x + Width), bottom);
+        if (!cull_rect.Overlaps(ImRect(Rmin, Rmax)))
+            return false;
+        PrimRectFill(draw_list, Rmin, Rmax, Col, UV);
+        return true;
+    }
+    const _Getter1& Getter1;
+    const _Getter2& Getter2;
+    const ImU32 Col;
+    const float HalfWeight;
+    mutable ImVec2 P1;
+    mutable float Width;
+    mutable float PrevTop;
+    mutable float PrevBottom;
+    mutable ImVec2 UV;
+};
+
 struct RectC {
     ImPlotPoint Pos;
     ImPlotPoint HalfSize;
@@ -1815,6 +1886,54 @@ void PlotShadedG(const char* label_id, ImPlotGetter getter_func1, void* data1, I
     PlotShadedEx(label_id, getter1, getter2, flags);
 }
 
+//-----------------------------------------------------------------------------
+// [SECTION] PlotWaveform
+//-----------------------------------------------------------------------------
+
+// columns further apart than this many pixels are joined by a line, bars would look like steps
+#define IMPLOT_WAVEFORM_MAX_BAR_SPACING 2.0f
+
+template <typename Getter1, typename Getter2>
+void PlotWaveformEx(const char* label_id, const Getter1& getter_min, const Getter2& getter_max, ImPlotWaveformFlags flags) {
+    if (BeginItemEx(label_id, Fitter2<Getter1,Getter2>(getter_min,getter_max), flags, ImPlotCol_Line)) {
+        const int count = ImMin(getter_min.Count, getter_max.Count);
+        if (count <= 0) {
+            EndItem();
+            return;
+        }
+        const ImPlotNextItemData& s = GetItemData();
+        if (s.RenderLine) {
+            const ImU32 col_line = ImGui::GetColorU32(s.Colors[ImPlotCol_Line]);
+            Transformer2 transformer;
+            const float spacing = count > 1 ? ImAbs(transformer(getter_min(count - 1)).x - transformer(getter_min(0)).x) / (count - 1) : 0;
+            if (spacing <= IMPLOT_WAVEFORM_MAX_BAR_SPACING)
+                RenderPrimitives2<RendererWaveformBars>(getter_min,getter_max,col_line,s.LineWeight);
+            else
+                RenderPrimitives1<RendererLineStrip>(GetterZigZag<Getter1,Getter2>(getter_min,getter_max),col_line,s.LineWeight);
+        }
+        EndItem();
+    }
+}
+
+template <typename T>
+void PlotWaveform(const char* label_id, const T* mins, const T* maxs, int count, double xscale, double x0, ImPlotWaveformFlags flags, int offset, int stride) {
+    GetterXY<IndexerLin,IndexerIdx<T>> getter_min(IndexerLin(xscale,x0),IndexerIdx<T>(mins,count,offset,stride),count);
+    GetterXY<IndexerLin,IndexerIdx<T>> getter_max(IndexerLin(xscale,x0),IndexerIdx<T>(maxs,count,offset,stride),count);
+    PlotWaveformEx(label_id, getter_min, getter_max, flags);
+}
+
+#define INSTANTIATE_MACRO(T) \
+    template IMPLOT_API void PlotWaveform<T>(const char* label_id, const T* mins, const T* maxs, int count, double xscale, double x0, ImPlotWaveformFlags flags, int offset, int stride);
+CALL_INSTANTIATE_FOR_NUMERIC_TYPES()
+#undef INSTANTIATE_MACRO
+
+// custom
+void PlotWaveformG(const char* label_id, ImPlotGetter getter_func_min, void* data_min, ImPlotGetter getter_func_max, void* data_max, int count, ImPlotWaveformFlags flags) {
+    GetterFuncPtr getter_min(getter_func_min, data_min, count);
+    GetterFuncPtr getter_max(getter_func_max, data_max, count);
+    PlotWaveformEx(label_id, getter_min, getter_max, flags);
+}
+
 //-----------------------------------------------------------------------------
 // [SECTION] PlotBars
 //-----------------------------------------------------------------------------
@@ -0,0 +1,454 @@
+#include "library_catalog.h"
+#include "wave_reader.h"
+#include "peak_file.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+//Layout, little-endian:
+//  CatalogFileHeader (32 bytes)
+//  entry_count x { CatalogRecord (56 bytes), path bytes padded to a multiple of 8 }
+
+//Bumped whenever the layout changes, catalogs of any other version are ignored and rebuilt
+static const unsigned int catalogFileVersion = 1;
+static const char catalogFileMagic[8] = "WVCATLG";
+
+struct CatalogFileHeader {
+    char magic[8];                      //"WVCATLG" and a terminating 0
+    unsigned int version;
+    unsigned int reserved;
+    unsigned long long entry_count;
+    unsigned long long reserved2;
+};
+
+struct CatalogRecord {
+    unsigned long long size;
+    long long mtime;
+    unsigned long long number_of_samples;
+    double duration;
+    float peak;
+    int sample_rate;
+    short audio_format;
+    short sub_format;
+    short num_channels;
+    short bits_per_sample;
+    short status;
+    short reserved;
+    unsigned int path_length;
+};
+
+static_assert(sizeof(CatalogFileHeader) == 32, "CatalogFileHeader must stay 32 bytes");
+static_assert(sizeof(CatalogRecord) == 56, "CatalogRecord must stay 56 bytes");
+
+#ifdef _WIN32
+static const char pathSeparator = '\\';
+#else
+static const char pathSeparator = '/';
+#endif
+
+static bool isWaveFile(const std::string& name)
+{
+    if (name.size() < 4)
+        return false;
+    std::string extension = name.substr(name.size() - 4);
+    for (char& c : extension)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return extension == ".wav";
+}
+
+//Append every WAV file below "directory" to "found", with its path relative to the root. Size and modification
+//time come with the directory listing, no file is opened here.
+static void listWaveFiles(const std::string& directory, const std::string& relative, std::vector<CatalogEntry>& found,
+                          ScanProgress* progress)
+{
+    if (progress != nullptr && progress->cancel)
+        return;
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE search = FindFirstFileA((directory + "\\*").c_str(), &data);
+    if (search == INVALID_HANDLE_VALUE)
+        return;
+    do
+    {
+        std::string name = data.cFileName;
+        if (name == "." || name == "..")
+            continue;
+        std::string path = relative.empty() ? name : relative + pathSeparator + name;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            //Junctions can point back up the tree
+            if (!(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+                listWaveFiles(directory + pathSeparator + name, path, found, progress);
+        }
+        else if (isWaveFile(name))
+        {
+            CatalogEntry entry;
+            entry.path = path;
+            entry.size = (static_cast<unsigned long long>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+            //FILETIME counts 100 ns steps from 1601, stored as seconds since 1970 like stat() reports
+            unsigned long long ticks = (static_cast<unsigned long long>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                                       data.ftLastWriteTime.dwLowDateTime;
+            entry.mtime = static_cast<long long>(ticks / 10000000ull) - 11644473600ll;
+            found.push_back(entry);
+            if (progress != nullptr)
+                progress->files_found++;
+        }
+    } while (FindNextFileA(search, &data));
+    FindClose(search);
+#else
+    DIR* handle = opendir(directory.c_str());
+    if (handle == nullptr)
+        return;
+    while (dirent* item = readdir(handle))
+    {
+        std::string name = item->d_name;
+        if (name == "." || name == "..")
+            continue;
+        std::string full = directory + pathSeparator + name;
+        std::string path = relative.empty() ? name : relative + pathSeparator + name;
+
+        //Symbolic links to directories can point back up the tree, only real directories are entered
+        struct stat info;
+        if (lstat(full.c_str(), &info) != 0)
+            continue;
+        if (S_ISDIR(info.st_mode))
+        {
+            listWaveFiles(full, path, found, progress);
+            continue;
+        }
+        if (!isWaveFile(name) || (S_ISLNK(info.st_mode) && stat(full.c_str(), &info) != 0) || !S_ISREG(info.st_mode))
+            continue;
+
+        CatalogEntry entry;
+        entry.path = path;
+        entry.size = static_cast<unsigned long long>(info.st_size);
+        entry.mtime = static_cast<long long>(info.st_mtime);
+        found.push_back(entry);
+        if (progress != nullptr)
+            progress->files_found++;
+    }
+    closedir(handle);
+#endif
+}
+
+//Largest sample magnitude of every channel of "reader", by decoding the whole file
+static float measurePeak(const WaveReader& reader)
+{
+    const size_t sliceFrames = 1 << 16;
+    const int channelCount = reader.channelCount();
+    std::vector<float> buffer(sliceFrames * channelCount);
+    std::vector<float*> channels(channelCount);
+    for (int c = 0; c < channelCount; c++)
+        channels[c] = buffer.data() + sliceFrames * c;
+
+    const ClipRange clip = clipRange(reader.getFormat());
+    ChannelStats stats;
+    for (size_t first = 0; first < reader.frameCount(); first += sliceFrames)
+    {
+        size_t count = reader.readFramesAt(first, channels.data(), sliceFrames);
+        for (int c = 0; c < channelCount; c++)
+            accumulateStats(channels[c], count, clip, stats);
+    }
+    return stats.peak();
+}
+
+//Fill the format fields of "entry" from the header of "fileName"
+static void probeEntry(const std::string& fileName, CatalogEntry& entry, const ScanOptions& options)
+{
+    //Only the header is read unless the whole file has to be decoded for its peak
+    WaveReader reader;
+    entry.status = reader.open(fileName, options.measure_peaks ? MapAccess::Sequential : MapAccess::Random);
+    if (entry.status != 0)
+        return;
+
+    const Wave& wave = reader.getWave();
+    entry.audio_format = wave.audio_format;
+    entry.sub_format = wave.sub_format;
+    entry.num_channels = wave.num_channels;
+    entry.bits_per_sample = wave.bits_per_sample;
+    entry.sample_rate = wave.sample_rate;
+    entry.number_of_samples = wave.number_of_samples;
+    entry.duration = wave.duration;
+
+    //The peak file holds it for anything that has been opened as an overview
+    entry.peak = -1.0f;
+    if (!readPeakLevel(fileName, reader, entry.peak) && options.measure_peaks)
+        entry.peak = measurePeak(reader);
+}
+
+std::string LibraryCatalog::fullPath(const CatalogEntry& entry) const
+{
+    if (root_directory.empty() || root_directory.back() == '/' || root_directory.back() == pathSeparator)
+        return root_directory + entry.path;
+    return root_directory + pathSeparator + entry.path;
+}
+
+bool LibraryCatalog::load(const std::string& rootDirectory)
+{
+    root_directory = rootDirectory;
+    entries.clear();
+
+    std::string path = cacheFilePath(rootDirectory, ".catalog");
+    MappedFile file;
+    if (path.empty() || !file.open(path))
+        return false;
+    ByteSpan bytes = file.bytes();
+    if (bytes.size < sizeof(CatalogFileHeader))
+        return false;
+    CatalogFileHeader header = bytes.read<CatalogFileHeader>(0);
+    if (std::memcmp(header.magic, catalogFileMagic, sizeof(header.magic)) != 0 || header.version != catalogFileVersion ||
+        header.entry_count > bytes.size / sizeof(CatalogRecord))
+        return false;
+
+    std::vector<CatalogEntry> loaded(static_cast<size_t>(header.entry_count));
+    size_t offset = sizeof(CatalogFileHeader);
+    for (CatalogEntry& entry : loaded)
+    {
+        if (offset + sizeof(CatalogRecord) > bytes.size)
+            return false;
+        CatalogRecord record = bytes.read<CatalogRecord>(offset);
+        offset += sizeof(CatalogRecord);
+        if (record.path_length > bytes.size - offset)
+            return false;
+        entry.path.assign(reinterpret_cast<const char*>(bytes.data + offset), record.path_length);
+        offset += (record.path_length + 7) & ~7u;
+
+        entry.size = record.size;
+        entry.mtime = record.mtime;
+        entry.status = record.status;
+        entry.audio_format = record.audio_format;
+        entry.sub_format = record.sub_format;
+        entry.num_channels = record.num_channels;
+        entry.bits_per_sample = record.bits_per_sample;
+        entry.sample_rate = record.sample_rate;
+        entry.number_of_samples = record.number_of_samples;
+        entry.duration = record.duration;
+        entry.peak = record.peak;
+    }
+    entries = std::move(loaded);
+    return true;
+}
+
+bool LibraryCatalog::save() const
+{
+    std::string path = cacheFilePath(root_directory, ".catalog");
+    if (path.empty())
+        return false;
+
+    //Write to a temporary file first and move it into place, like peak files
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        if (!output)
+            return false;
+        CatalogFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, catalogFileMagic, sizeof(header.magic));
+        header.version = catalogFileVersion;
+        header.entry_count = entries.size();
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const char padding[8] = {};
+        for (const CatalogEntry& entry : entries)
+        {
+            CatalogRecord record;
+            std::memset(&record, 0, sizeof(record));
+            record.size = entry.size;
+            record.mtime = entry.mtime;
+            record.number_of_samples = entry.number_of_samples;
+            record.duration = entry.duration;
+            record.peak = entry.peak;
+            record.sample_rate = entry.sample_rate;
+            record.audio_format = entry.audio_format;
+            record.sub_format = entry.sub_format;
+            record.num_channels = entry.num_channels;
+            record.bits_per_sample = entry.bits_per_sample;
+            record.status = static_cast<short>(entry.status);
+            record.path_length = static_cast<unsigned int>(entry.path.size());
+            output.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            output.write(entry.path.data(), entry.path.size());
+            output.write(padding, (8 - entry.path.size() % 8) % 8);
+        }
+        output.flush();
+        if (!output)
+        {
+            output.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    //rename() does not replace an existing file on Windows
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+int LibraryCatalog::scan(const ScanOptions& options, ScanProgress* progress)
+{
+    //An unreadable root would otherwise look like an empty one and wipe the catalog
+    unsigned long long rootSize;
+    long long rootTime;
+    if (!fileStamp(root_directory, rootSize, rootTime))
+    {
+        std::cout << "ERROR: Cannot read " << root_directory << std::endl;
+        return -1;
+    }
+
+    std::vector<CatalogEntry> found;
+    listWaveFiles(root_directory, "", found, progress);
+    if (progress != nullptr && progress->cancel)
+        return -1;
+    std::sort(found.begin(), found.end(), [](const CatalogEntry& a, const CatalogEntry& b) { return a.path < b.path; });
+
+    //Unchanged files keep what is known about them, the rest is probed
+    std::vector<size_t> changed;
+    for (size_t i = 0; i < found.size(); i++)
+    {
+        auto known = std::lower_bound(entries.begin(), entries.end(), found[i].path,
+                                      [](const CatalogEntry& entry, const std::string& path) { return entry.path < path; });
+        bool unchanged = known != entries.end() && known->path == found[i].path && known->size == found[i].size &&
+                         known->mtime == found[i].mtime;
+        if (unchanged && !(options.measure_peaks && known->status == 0 && known->peak < 0.0f))
+            found[i] = *known;
+        else
+            changed.push_back(i);
+    }
+    if (progress != nullptr)
+        progress->files_total = changed.size();
+
+    //Opening a file costs far more than the work done on it, so keep many in flight
+    ThreadPool::shared().parallelFor(changed.size(), 16, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            if (progress != nullptr && progress->cancel)
+                return;
+            CatalogEntry& entry = found[changed[i]];
+            probeEntry(fullPath(entry), entry, options);
+            if (progress != nullptr)
+                progress->files_probed++;
+        }
+    });
+    if (progress != nullptr && progress->cancel)
+        return -1;
+
+    std::cout << "Indexed " << found.size() << " files in " << root_directory << " (" << changed.size() << " probed)" << std::endl;
+    entries = std::move(found);
+    return 0;
+}
+
+static std::string lowerCase(std::string text)
+{
+    for (char& c : text)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+std::vector<size_t> LibraryCatalog::search(const std::string& query) const
+{
+    std::vector<std::string> words;
+    std::string lowered = lowerCase(query);
+    size_t start = 0;
+    while (start < lowered.size())
+    {
+        size_t end = lowered.find(' ', start);
+        if (end == std::string::npos)
+            end = lowered.size();
+        if (end > start)
+            words.push_back(lowered.substr(start, end - start));
+        start = end + 1;
+    }
+
+    std::vector<size_t> matches;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        std::string path = lowerCase(entries[i].path);
+        bool match = true;
+        for (const std::string& word : words)
+        {
+            if (path.find(word) == std::string::npos)
+            {
+                match = false;
+                break;
+            }
+        }
+        if (match)
+            matches.push_back(i);
+    }
+    return matches;
+}
+
+LibraryIndexer::~LibraryIndexer()
+{
+    cancel();
+    if (worker.joinable())
+        worker.join();
+}
+
+void LibraryIndexer::start(const std::string& rootDirectory, const ScanOptions& options)
+{
+    //Only one scan at a time, a previous (possibly cancelled) worker must be gone first
+    if (worker.joinable())
+        worker.join();
+
+    state.files_found = 0;
+    state.files_probed = 0;
+    state.files_total = 0;
+    state.cancel = false;
+    result.reset();
+    result_status = -1;
+    finished = false;
+    scanning = true;
+
+    worker = std::thread([this, rootDirectory, options]()
+    {
+        std::unique_ptr<LibraryCatalog> catalog(new LibraryCatalog());
+        catalog->load(rootDirectory);
+        int status = catalog->scan(options, &state);
+        if (status == 0 && !catalog->save())
+            std::cout << "WARNING: Could not write the catalog of " << rootDirectory << std::endl;
+
+        result = std::move(catalog);
+        result_status = status;
+
+        //Publish the result, everything written above is visible to the thread that observes finished == true
+        finished.store(true, std::memory_order_release);
+    });
+}
+
+void LibraryIndexer::cancel()
+{
+    state.cancel = true;
+}
+
+bool LibraryIndexer::poll(LibraryCatalog& catalog, int& status)
+{
+    if (!scanning || !finished.load(std::memory_order_acquire))
+        return false;
+
+    worker.join();
+    scanning = false;
+    status = state.cancel ? -1 : result_status;
+    if (status == 0)
+        catalog = std::move(*result);
+    result.reset();
+    return true;
+}
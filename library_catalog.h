@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Metadata of every WAV file below one directory, so large libraries can be browsed and searched without opening
+//each file. The catalog is kept on disk and rescans only probe files that are new or whose size or modification
+//time changed since the last scan.
+
+struct CatalogEntry {
+    std::string path;                   //Relative to the catalog's root directory
+    unsigned long long size = 0;
+    long long mtime = 0;
+    int status = -1;                    //0 when the header could be parsed
+    short audio_format = 0;
+    short sub_format = 0;
+    short num_channels = 0;
+    short bits_per_sample = 0;
+    int sample_rate = 0;
+    unsigned long long number_of_samples = 0;
+    double duration = 0.0;
+    float peak = -1.0f;                 //Largest sample magnitude, negative while unknown
+};
+
+//Choices made before a scan
+struct ScanOptions {
+    //Decode files without a peak file to measure their peak level. Reads every new or changed file in full.
+    bool measure_peaks = false;
+};
+
+//Files found and probed so far, shared between a scanning thread and the UI
+struct ScanProgress {
+    std::atomic<size_t> files_found{ 0 };
+    std::atomic<size_t> files_probed{ 0 };
+    std::atomic<size_t> files_total{ 0 };
+    std::atomic<bool> cancel{ false };
+};
+
+class LibraryCatalog {
+public:
+    const std::string& root() const { return root_directory; }
+    const std::vector<CatalogEntry>& getEntries() const { return entries; }
+    //Root and relative path joined
+    std::string fullPath(const CatalogEntry& entry) const;
+
+    //Read the catalog of "rootDirectory" from the cache directory. Returns false, leaving the catalog empty but
+    //rooted at "rootDirectory", if there is none or it cannot be read.
+    bool load(const std::string& rootDirectory);
+    //Write the catalog to the cache directory. Returns false if it could not be written.
+    bool save() const;
+
+    //Walk the root directory and bring the catalog up to date. Unchanged files keep their entry, the others are
+    //probed in parallel on the shared thread pool. Returns 0 on success and -1 if the root cannot be read or
+    //progress->cancel was raised, the catalog is then left as it was. "progress" may be nullptr.
+    int scan(const ScanOptions& options = ScanOptions(), ScanProgress* progress = nullptr);
+
+    //Indices of the entries whose path contains every space separated word of "query", ignoring case
+    std::vector<size_t> search(const std::string& query) const;
+
+private:
+    std::string root_directory;
+    std::vector<CatalogEntry> entries;      //Sorted by path
+};
+
+//Runs LibraryCatalog::load() and scan() on a worker thread so huge libraries do not stall the UI
+class LibraryIndexer {
+public:
+    LibraryIndexer() = default;
+    ~LibraryIndexer();
+
+    LibraryIndexer(const LibraryIndexer&) = delete;
+    LibraryIndexer& operator=(const LibraryIndexer&) = delete;
+
+    void start(const std::string& rootDirectory, const ScanOptions& options = ScanOptions());
+    void cancel();
+
+    bool isScanning() const { return scanning; }
+    const ScanProgress& progress() const { return state; }
+
+    //Call once per frame. When the worker has finished, joins it, hands over the catalog (only on success) and
+    //returns true with scan()'s result in "status".
+    bool poll(LibraryCatalog& catalog, int& status);
+
+private:
+    std::thread worker;
+    ScanProgress state;
+    std::atomic<bool> finished{ false };
+    bool scanning = false;
+
+    //Written by the worker before it sets "finished"
+    std::unique_ptr<LibraryCatalog> result;
+    int result_status = -1;
+};
@@ -5,18 +5,48 @@
 #include "implot.h"
 #include "implot_internal.h"
 #include "wave.h"
-#include <fstream>
+#include "waveform_lod.h"
+#include "wave_loader.h"
+#include "probe.h"
+#include "library_catalog.h"
+#include "frame_scheduler.h"
+#include "geometry_cache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
 
 
 //Window object
 GLFWwindow* window;
+//Only draws when something changed, instead of every vsync
+FrameScheduler scheduler;
 float displayX = 0.0f;
 float displayY = 0.0f;
 
-//Data needed for plot
-std::vector<float> amplitude_vector_channel1;
-std::vector<float> amplitude_vector_channel2;
-std::vector<float> audio_time;
+//Data needed for plot, replaced as a whole when a load finishes
+std::unique_ptr<LoadedAudio> loaded_audio;
+//Length of the start of a huge file that is shown while its overview is being built
+const double previewSeconds = 10.0;
+
+//Decodes files off the render thread
+AsyncLoader loader;
+
+//Keeps appending to loaded_audio while its file is still being recorded
+TailFollower follower;
+//Length of the end of a followed file that is kept in view
+const double followSeconds = 10.0;
+
+//Most vertices the channel plots may add to one frame, shared evenly between the channels. When so many or so
+//wide plots would need more for a column per pixel, their columns are made coarser instead.
+const size_t waveformVertexBudget = 262144;
+//Vertices and draw calls of the last frame, shown in the Properties window
+int frame_vertices = 0;
+int frame_draw_calls = 0;
+
+//Catalog of the library folder shown in the file browser, and the scan that refreshes it
+LibraryCatalog library;
+LibraryIndexer indexer;
 
 //Window and ImGui setup code
 void setup()
@@ -46,6 +76,9 @@ void setup()
     //Enable cursor inside window
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 
+    //Watch for input before the ImGui backend hooks in, it forwards the events to us
+    scheduler.attach(window);
+
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -72,189 +105,93 @@ void cleanup()
     glfwTerminate();
 }
 
-//Helper function used by readFile() to iterate until "data" is found from startPos onwards.
-int findData(std::ifstream& inputFile, int startPos)
+//Plot one channel into the current plot. Only the frames inside the plot's time axis limits are read, reduced to
+//one or two min/max columns per pixel, so PlotWaveform gets about as many columns as the plot is wide however
+//long the file is. Frames from viewEnd on are left out. The columns are made coarser until they take at most
+//maxVertices, returns true when that was needed.
+bool plotWaveform(LoadedAudio& audio, int channel, size_t viewEnd, size_t maxVertices)
 {
-    bool dataFound = false;
-    int subchunk2SizePosition = 0;
-    char dataPattern[] = "data";
-
-    //File must be open
-    if (!inputFile.is_open())
-        return -1;
-
-    //Get the File Size
-    inputFile.seekg(-4, std::ios::end);
-    int fileSize = inputFile.tellg();
-
-    //Place cursor to desired location
-    inputFile.seekg(startPos, std::ios::beg);
-
-    //Seek through file to find "data". Some files have multiple "data"s. Find the one that is not followed by all zeros (some of this logic is in readFile)
-    for(int i = startPos; i < fileSize; i++)
+    int sampleRate = audio.wave.sample_rate;
+    if (sampleRate <= 0)
+        return false;
+
+    ImPlotRect limits = ImPlot::GetPlotLimits();
+    double first = std::max(limits.X.Min, 0.0) * sampleRate;
+    double last = std::min(limits.X.Max * sampleRate, static_cast<double>(viewEnd));
+    if (last <= first)
+        return false;
+
+    //Columns span a power of two of frames, the largest that still gives every pixel a column of its own, and
+    //start at multiples of that size. Their edges then fall on bucket edges of the pyramid level matching the
+    //zoom, so each column is read from exactly one level, and panning only moves columns in and out at the sides
+    //instead of regrouping the frames under every column.
+    double framesPerPixel = limits.X.Size() * sampleRate / ImPlot::GetPlotSize().x;
+    size_t columnFrames = 1;
+    while (columnFrames * 2 <= framesPerPixel)
+        columnFrames *= 2;
+    //Over budget the next coarser levels are used. A column takes 4 vertices, 8 once columns are more than two
+    //pixels apart and PlotWaveform joins them with a line instead.
+    bool coarsened = false;
+    for (;;)
     {
-        //Read 4 bytes, store values in char array
-        char buffer[4];
-
-        //Read 4 bytes, this moves cursor 4 bytes forwards after reading
-        inputFile.read(buffer, sizeof(buffer)); 
-
-        //Check to see if buffer == "data"
-        if (std::memcmp(buffer, dataPattern, 4) == 0)
-        {
-            dataFound = true;
+        double columns = (last - first) / columnFrames;
+        double vertices = columns * (columnFrames > 2.0 * framesPerPixel ? 8.0 : 4.0);
+        if (columns <= 1.0 || vertices <= static_cast<double>(maxVertices))
             break;
-        }
-
-        //If data was not found, move back 3 bytes to check the next 4 byte set
-        else
-            inputFile.seekg(-3, std::ios::cur);
+        columnFrames *= 2;
+        coarsened = true;
     }
-
-    //If we reached the end of the file without finding a valid data chunk then stop the program
-    if (!dataFound)
+    //One column past the right edge so the waveform runs up to it
+    size_t start = static_cast<size_t>(first) / columnFrames * columnFrames;
+    size_t end = std::min(static_cast<size_t>(std::ceil(last)) + columnFrames, viewEnd);
+    size_t wholeEnd = start + (end - start) / columnFrames * columnFrames;
+
+    static std::vector<float> column_min;
+    static std::vector<float> column_max;
+    size_t wholeColumns = (wholeEnd - start) / columnFrames;
+    size_t count = 0;
+    column_min.clear();
+    column_max.clear();
+    if (wholeColumns > 0)
+        count = queryColumns(audio, channel, start, wholeEnd, wholeColumns, column_min, column_max);
+    //The last frames of the file or preview rarely fill a whole column, they get a shorter one
+    if (wholeEnd < end && count == wholeColumns)
     {
-        std::cout << "ERROR: Read " << inputFile.tellg() << "/" << fileSize << " Bytes. Valid data chunk cannot be found!" << std::endl;
-        return -1;
+        static std::vector<float> tail_min;
+        static std::vector<float> tail_max;
+        if (queryColumns(audio, channel, wholeEnd, end, 1, tail_min, tail_max) == 1)
+        {
+            column_min.push_back(tail_min[0]);
+            column_max.push_back(tail_max[0]);
+            count++;
+        }
     }
-
-    //Save the cursor position for the start of audio data size (the chunk followed by "data")
-    subchunk2SizePosition = inputFile.tellg();
-    return subchunk2SizePosition;
+    if (count == 0)
+        return coarsened;
+
+    //Each column is drawn as one quad from its min to its max
+    double startSeconds = static_cast<double>(start) / sampleRate;
+    double columnSeconds = static_cast<double>(columnFrames) / sampleRate;
+    ImPlot::SetNextLineStyle(ImVec4(0.78f, 0.78f, 0.78f, 1.0f), 1.0f);
+    ImPlot::PlotWaveform("##Waveform", column_min.data(), column_max.data(), static_cast<int>(count), columnSeconds, startSeconds);
+    return coarsened;
 }
 
-//Read the file by bytes to extract data from the .wav file
-int readFile(std::string fileName, Wave& wave)
+//Last geometry of one channel plot, and whether the vertex budget made its columns coarser
+struct ChannelGeometry {
+    GeometryCache cache;
+    bool coarsened = false;
+};
+
+//Show the sample and time under the cursor of the current plot
+void showCursorTime(int sampleRate)
 {
-    //Clear previous vectors
-    std::vector<float> dumb1;
-    std::vector<float> dumb2;
-    std::vector<float> dumb3;
-
-    swap(dumb2,amplitude_vector_channel1);
-    swap(dumb3,amplitude_vector_channel2);
-    swap(dumb1, audio_time);
-
-    //Open Wav file and read
-    std::ifstream inputFile(fileName, std::ifstream::binary);
-    if (inputFile.is_open()) 
+    if (ImPlot::IsPlotHovered() && sampleRate > 0)
     {
-        //GET HEADER INFO
-        char header[36];
-
-        //Read first 36 bytes
-        inputFile.seekg(0, std::ios::beg);
-        inputFile.read(header, sizeof(header));
-        
-        //Check if the file is WAVE
-        char file_type[5];
-        std::copy(&header[8], &header[8]+4, file_type);
-        file_type[4] = '\0';
-        if (std::string(file_type) != "WAVE")
-            return -1;
-
-
-        //Gather "fmt" sub-chunk info
-        wave.subchunk1_size = *reinterpret_cast<int*>(&header[16]);
-        wave.audio_format = *reinterpret_cast<short*>(&header[20]);
-        wave.num_channels = *reinterpret_cast<short*>(&header[22]);
-        wave.sample_rate = *reinterpret_cast<int*>(&header[24]);
-        wave.byte_rate = *reinterpret_cast<int*>(&header[28]);
-        wave.block_align = *reinterpret_cast<short*>(&header[32]);
-        wave.bits_per_sample = *reinterpret_cast<short*>(&header[34]);
-
-        //The size of each sample in bytes if wave.sample_size = 4, sample size is 4, channel 1 size = 2, channel 2 size = 2
-        wave.sample_size = (wave.bits_per_sample / 8) * wave.num_channels;
-
-        //Create a buffer to read the data size chunk
-        char dataSizeBuffer[4];
-        //Read the data chunk following "data"
-        //If that integer is 0, the file is messed up and probably has a data chunk elsewhere as seen in audio2.wav
-        int subchunk2SizePosition = 0;
-        
-        //Specific to assignment, audio2.wav has an issue where it has 2 "data" chunks, one is all zeros, the other has actual data.
-        //By reading the size, we can check if the size of subchunk2_size is 0, if it is no data exists. Another "data" chunk may exist
-        //so continue iterating until it is found. If its not found and all bytes are read then return an error
-        while (wave.subchunk2_size == 0)
-        {
-            //Find the position of the "data" chunk
-            subchunk2SizePosition = findData(inputFile, subchunk2SizePosition);
-            if (subchunk2SizePosition == -1)
-            {
-                inputFile.close();
-                std::cout << "ERROR: " << fileName << " cannot be read." << std::endl;
-                return -1;
-            }
-            //Read the next 4 bytes (the size chunk)
-            inputFile.read(dataSizeBuffer, 4);
-            //Cast the value into an integer
-            wave.subchunk2_size = *reinterpret_cast<int*>(&dataSizeBuffer);
-        }
-        
-        wave.number_of_samples = wave.subchunk2_size / (wave.num_channels * (wave.bits_per_sample / 8));
-        wave.duration = (float)wave.number_of_samples / (float)wave.sample_rate;
-
- 
-        int sampleCounter = 1;
-        char* bytes = new char[wave.block_align];
-        inputFile.seekg(subchunk2SizePosition, std::ios::beg);
-
-        //This allows support for 4, 6, and 8 byte block aligns (ie 
-        short amplitude1s;
-        short amplitude2s;
-        int amplitude1i;
-        int amplitude2i;
-        float amplitude1f;
-        float amplitude2f;
-
-        int halfway_byte = wave.block_align / 2;
-        while (inputFile.read(bytes, wave.block_align)) 
-        {
-            //Set sample values
-            switch (wave.block_align)
-            {
-                //8-bit depth (not yet implemented)
-
-                //16-bit depth
-                case 4:
-                    amplitude1s = *reinterpret_cast<short*>(&bytes[0]);
-                    amplitude2s = *reinterpret_cast<short*>(&bytes[halfway_byte]);
-                    amplitude_vector_channel1.push_back(static_cast<float>(amplitude1s));
-                    amplitude_vector_channel2.push_back(static_cast<float>(amplitude2s));
-                    break;
-                //32-bit depth
-                case 6:
-                    //Special case: no data type of 3 bytes exist. Shifting method used instead
-                    //Little Endian (https://stackoverflow.com/questions/9896589/how-do-you-read-in-a-3-byte-size-value-as-an-integer-in-c)
-                    amplitude1i = bytes[2] + (bytes[1] << 8) + (bytes[0] << 16);
-                    amplitude2i = bytes[5] + (bytes[4] << 8) + (bytes[3] << 16);
-                    amplitude_vector_channel1.push_back(static_cast<float>(amplitude1i));
-                    amplitude_vector_channel2.push_back(static_cast<float>(amplitude2i));
-                    break;
-                //32-bit depth
-                case 8:
-                    amplitude1f = *reinterpret_cast<float*>(&bytes[0]);
-                    amplitude2f = *reinterpret_cast<float*>(&bytes[halfway_byte]);
-                    amplitude_vector_channel1.push_back(static_cast<float>(amplitude1f));
-                    amplitude_vector_channel2.push_back(static_cast<float>(amplitude2f));
-                    break;
-
-            }
-            audio_time.push_back( sampleCounter );    
-            sampleCounter++;
-        }
-
-        //Less elegant, but a more consistent way to measure time
-        wave.number_of_samples = sampleCounter;
-        wave.duration = (float)wave.number_of_samples / (float)wave.sample_rate;
-        std::cout << "Loaded Succesfully" << std::endl;
-    }
-    else {
-        std::cerr << "Error: Unable to open the file: " << fileName << std::endl;
-        return -1;
+        double seconds = ImPlot::GetPlotMousePos().x;
+        if (seconds >= 0.0)
+            ImGui::SetTooltip("Sample %zu\n%.4f s", static_cast<size_t>(seconds * sampleRate), seconds);
     }
-    inputFile.close();
-    return 0;
 }
 
 void helpMarker(const char* desc)
@@ -269,20 +206,167 @@ void helpMarker(const char* desc)
     }
 }
 
+//Peak level in dB relative to full scale, from the raw sample value a catalog entry holds
+float peakDecibels(const CatalogEntry& entry)
+{
+    bool isFloat = entry.audio_format == 3 || entry.sub_format == 3;
+    double fullScale = (isFloat || entry.bits_per_sample <= 1) ? 1.0 : static_cast<double>(1ull << (entry.bits_per_sample - 1));
+    if (entry.peak <= 0.0f)
+        return -INFINITY;
+    return static_cast<float>(20.0 * std::log10(entry.peak / fullScale));
+}
+
+//Searchable list of every WAV file below a folder. Returns true with the path in "selected" when a file is
+//double clicked.
+bool drawLibraryWindow(std::string& selected)
+{
+    static char root_buffer[256] = "test samples";
+    static char search_buffer[128] = "";
+    static ScanOptions scan_options;
+    static std::vector<size_t> matches;
+    static bool matches_stale = true;
+    static bool scan_failed = false;
+    bool picked = false;
+
+    //Pick up a finished scan
+    int scan_status = 0;
+    if (indexer.poll(library, scan_status))
+    {
+        scan_failed = scan_status != 0 && !indexer.progress().cancel;
+        matches_stale = true;
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(displayX * 0.65f, displayY), ImGuiCond_Once);
+    ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Once);
+    ImGui::Begin("Library");
+    {
+        ImGui::Text("Folder");
+        ImGui::InputText("##Library Folder", root_buffer, sizeof(root_buffer));
+        ImGui::SameLine();
+        ImGui::BeginDisabled(indexer.isScanning());
+        if (ImGui::Button("Scan"))
+        {
+            //Show what the last scan found right away, the rescan only probes what changed since
+            if (library.root() != root_buffer)
+                library.load(root_buffer);
+            matches_stale = true;
+            scan_failed = false;
+            indexer.start(root_buffer, scan_options);
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Measure Peaks", &scan_options.measure_peaks);
+        ImGui::EndDisabled();
+        ImGui::SameLine(); helpMarker(
+            "Decode files that have no peak file to measure their peak level.\nSlow on the first scan, later scans only decode new or changed files.\n");
+
+        if (indexer.isScanning())
+        {
+            const ScanProgress& progress = indexer.progress();
+            size_t total = progress.files_total;
+            char overlay[64];
+            if (total == 0)
+                snprintf(overlay, sizeof(overlay), "%zu files found", static_cast<size_t>(progress.files_found));
+            else
+                snprintf(overlay, sizeof(overlay), "%zu / %zu probed", static_cast<size_t>(progress.files_probed), total);
+            ImGui::ProgressBar(total == 0 ? 0.0f : static_cast<float>(progress.files_probed) / total, ImVec2(-100.0f, 0.0f), overlay);
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel##Scan"))
+                indexer.cancel();
+        }
+        else if (scan_failed)
+        {
+            ImGui::Text("Failed to scan. Check the folder path and try again.");
+        }
+
+        ImGui::Text("Search");
+        if (ImGui::InputText("##Library Search", search_buffer, sizeof(search_buffer)))
+            matches_stale = true;
+        if (matches_stale)
+        {
+            matches = library.search(search_buffer);
+            matches_stale = false;
+        }
+        ImGui::SameLine();
+        ImGui::Text("%zu of %zu files", matches.size(), library.getEntries().size());
+
+        //Only the visible rows are submitted, the list may hold tens of thousands of files
+        ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                ImGuiTableFlags_Resizable;
+        if (ImGui::BeginTable("##Library Files", 6, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("File", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("Channels", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableSetupColumn("Rate", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableSetupColumn("Bits", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableSetupColumn("Duration (s)", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableSetupColumn("Peak (dBFS)", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableHeadersRow();
+
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(matches.size()));
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+                {
+                    const CatalogEntry& entry = library.getEntries()[matches[row]];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::PushID(row);
+                    ImGui::BeginDisabled(entry.status != 0);
+                    if (ImGui::Selectable(entry.path.c_str(), false, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick) &&
+                        ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+                    {
+                        selected = library.fullPath(entry);
+                        picked = true;
+                    }
+                    ImGui::EndDisabled();
+                    ImGui::PopID();
+                    if (entry.status != 0)
+                        continue;
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%i", entry.num_channels);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%i", entry.sample_rate);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%i", entry.bits_per_sample);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", entry.duration);
+                    ImGui::TableNextColumn();
+                    if (entry.peak >= 0.0f)
+                        ImGui::Text("%.1f", peakDecibels(entry));
+                    else
+                        ImGui::TextDisabled("-");
+                }
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+    return picked;
+}
+
 //Main code
-int main()
+int main(int argc, char** argv)
 { 
+    //Command line tools run without opening a window
+    if (argc > 1 && std::strcmp(argv[1], "probe") == 0)
+        return runProbeCommand(argc, argv);
+
     //Setup Graphical User Interface
     setup();
 
     bool is_file_open = false;
     static char file_name_buffer[256] = "test samples/Q1/";
     std::string file_name = "";
-    Wave wave;
+    Wave empty_wave;
+    LoadOptions load_options;
 
     // Main loop        
     bool failed_to_load = false;
-    ImVec2 windowSize(0.0f, 0.0f);
+    bool load_cancelled = false;
+    //The time axis is zoomed out fully when the next file is shown
+    bool reset_view = true;
 
     while (!glfwWindowShouldClose(window))
     {
@@ -296,61 +380,151 @@ int main()
         ImGui::NewFrame();
 
         //ImPlot::ShowDemoWindow();
+
+        //Pick up a finished background load
+        int load_status = 0;
+        std::unique_ptr<LoadedAudio> finished_audio;
+        if (loader.poll(finished_audio, load_status))
+        {
+            scheduler.invalidate();
+            if (load_status == 0)
+            {
+                follower.stop();
+                loaded_audio = std::move(finished_audio);
+                file_name = loader.fileName();
+                is_file_open = true;
+                failed_to_load = false;
+            }
+            else
+            {
+                failed_to_load = !load_cancelled;
+            }
+        }
+
+        //Frames recorded since the last poll
+        if (loaded_audio && follower.update(*loaded_audio) > 0)
+            scheduler.invalidate();
+
+        //Work in the background shows progress, keep drawing while it runs
+        if (loader.isLoading())
+            scheduler.requestFrameWithin(1.0 / 30.0);
+        if (indexer.isScanning())
+            scheduler.requestFrameWithin(1.0 / 10.0);
+        if (follower.isFollowing())
+            scheduler.requestFrameWithin(TailFollower::pollMilliseconds / 1000.0);
+        //The text cursor blinks
+        if (ImGui::GetIO().WantTextInput)
+            scheduler.requestFrameWithin(0.25);
+
+        //Huge files are shown from their page cache while the overview is still being built
+        LoadedAudio* audio = loaded_audio ? loaded_audio.get() : loader.preview();
+        bool previewing = !loaded_audio && audio != nullptr;
+        const Wave& wave = audio ? audio->wave : empty_wave;
         
         //Wave Form Window
-        if (is_file_open)
+        if ((is_file_open && loaded_audio) || previewing)
         {   
-
-            //Set waveform window size and position
-            ImGui::SetNextWindowSize(ImVec2(displayX, (displayY/2.0)), ImGuiCond_Once);
+            if (previewing)
+                file_name = loader.fileName();
+
+            //Until the overview is ready only the start of the file is shown, that only needs a few pages decoded.
+            //Files with a peak file are shown whole while their samples decode.
+            size_t viewEnd = static_cast<size_t>(wave.number_of_samples);
+            if (!audio->overview_ready)
+                viewEnd = std::min(viewEnd, static_cast<size_t>(previewSeconds * wave.sample_rate));
+
+            //A followed file scrolls along with the recording, its newest seconds stay in view
+            size_t viewStart = 0;
+            size_t followFrames = static_cast<size_t>(followSeconds * wave.sample_rate);
+            if (follower.isFollowing() && viewEnd > followFrames)
+                viewStart = viewEnd - followFrames;
+
+            //One plot per channel, stacked to fill the left side. Their time axes are linked, zooming or panning
+            //one moves them all.
+            int channelCount = wave.num_channels;
+            double viewSeconds = static_cast<double>(viewEnd) / std::max(wave.sample_rate, 1);
+            static std::vector<ChannelGeometry> waveform_cache;
+            waveform_cache.resize(channelCount);
+            size_t channelVertices = waveformVertexBudget / std::max(channelCount, 1);
+            //Set when the budget coarsened any channel drawn this frame
+            bool over_budget = false;
+            ImGui::SetNextWindowSize(ImVec2(displayX, displayY), ImGuiCond_Always);
             ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
-            
-            //Display waveform
-            ImGui::Begin("Channel 1");
+            ImGui::Begin("Waveform");
+            if (ImPlot::BeginSubplots("##Channels", std::max(channelCount, 1), 1, ImVec2(-1, -1), ImPlotSubplotFlags_LinkAllX))
             {
-                // Scale factor to fit the points within the window
-                windowSize = ImGui::GetWindowSize();
-                float scaleFactorX = windowSize.x / audio_time.size();
-                float scaleFactorY = (windowSize.y * 0.8) / *std::max_element(amplitude_vector_channel1.begin(), amplitude_vector_channel1.end());
-                ImVec2 windowCenter = ImVec2(windowSize.x / 2.0f, windowSize.y / 2.0f);
-
-                //Plot points, draw line
-                for (int i = 0; i < audio_time.size() - 1; ++i) {
-                    ImGui::GetWindowDrawList()->AddLine(
-                        ImVec2(audio_time[i] * scaleFactorX, -1.0f * (amplitude_vector_channel1[i] * scaleFactorY/2) + windowCenter.y),
-                        ImVec2(audio_time[i + 1] * scaleFactorX, -1.0f * (amplitude_vector_channel1[i + 1] * scaleFactorY/2) + windowCenter.y),
-                        IM_COL32(200, 200, 200, 255)
-                    );
-                }
-            }
-            ImGui::End();
-
-
-            //Set waveform window size and position
-            ImGui::SetNextWindowSize(ImVec2(displayX, displayY / 2), ImGuiCond_Once);
-            ImGui::SetNextWindowPos(ImVec2(0, displayY/2), ImGuiCond_Always);
+                for (int c = 0; c < channelCount; c++)
+                {
+                    char title[32];
+                    snprintf(title, sizeof(title), "Channel %d", c + 1);
+                    if (!ImPlot::BeginPlot(title, ImVec2(), ImPlotFlags_NoLegend))
+                        continue;
+
+                    //The amplitude axis is fixed by the channel's peak found while decoding or read from the peak
+                    //file. Until the overview is ready there are no statistics, it fits to what is visible.
+                    float peak = 0.0f;
+                    bool knownPeak = audio->overview_ready && c < static_cast<int>(wave.channel_stats.size());
+                    if (knownPeak)
+                        peak = wave.channel_stats[c].peak();
+                    if (peak <= 0.0f)
+                        peak = 1.0f;
+                    ImPlot::SetupAxes(c == channelCount - 1 ? "Time (s)" : nullptr, nullptr, ImPlotAxisFlags_None,
+                                      knownPeak ? ImPlotAxisFlags_Lock : ImPlotAxisFlags_AutoFit);
+                    if (knownPeak)
+                        ImPlot::SetupAxisLimits(ImAxis_Y1, -peak / 0.8, peak / 0.8, ImPlotCond_Always);
+
+                    //Wheel zoom, drag-pan and right-drag box zoom are ImPlot's own and apply to all plots through
+                    //the linked axis, from the whole file down to a handful of frames. A new file starts fully
+                    //zoomed out. A followed file scrolls along with the recording.
+                    double minSeconds = 8.0 / std::max(wave.sample_rate, 1);
+                    ImPlot::SetupAxisLimitsConstraints(ImAxis_X1, 0.0, std::max(viewSeconds, minSeconds));
+                    ImPlot::SetupAxisZoomConstraints(ImAxis_X1, minSeconds, std::max(viewSeconds, minSeconds));
+                    if (follower.isFollowing())
+                        ImPlot::SetupAxisLimits(ImAxis_X1, static_cast<double>(viewStart) / wave.sample_rate, viewSeconds, ImPlotCond_Always);
+                    else if (reset_view)
+                        ImPlot::SetupAxisLimits(ImAxis_X1, 0.0, viewSeconds, ImPlotCond_Always);
+                    ImPlot::SetupFinish();
+
+                    //Double-click zooms out to the whole file. The waveform item only covers the visible columns,
+                    //the fit is told the full extent instead.
+                    ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+                    if (plot.Axes[ImAxis_X1].FitThisFrame)
+                    {
+                        ImPlot::FitPointX(0.0);
+                        ImPlot::FitPointX(viewSeconds);
+                    }
 
-            ImGui::Begin("Channel 2");
-            {
-                // Scale factor to fit the points within the window
-                windowSize = ImGui::GetWindowSize();
-                float scaleFactorX = windowSize.x / audio_time.size();
-                float scaleFactorY = (windowSize.y * 0.8) / *std::max_element(amplitude_vector_channel2.begin(), amplitude_vector_channel2.end());
-                ImVec2 windowCenter = ImVec2(windowSize.x / 2.0f, windowSize.y / 2.0f);
-
-                //Plot points, draw line
-                for (int i = 0; i < audio_time.size() - 1; ++i) {
-                    ImGui::GetWindowDrawList()->AddLine(
-                        //Scale and flip signs of amplitude to fit scale for window
-                        ImVec2((audio_time[i] * scaleFactorX), -1.0f * (amplitude_vector_channel2[i] * scaleFactorY/2) + (displayY /2) + (windowCenter.y)),
-                        ImVec2((audio_time[i + 1] * scaleFactorX), -1.0f * (amplitude_vector_channel2[i + 1] * scaleFactorY/2) + (displayY / 2) + (windowCenter.y)),
-                        IM_COL32(200, 200, 200, 255)
-                    );
+                    //Same data, limits, plot area and scale as last frame: copy last frame's vertices as they are
+                    ImPlotRect limits = ImPlot::GetPlotLimits();
+                    GeometryCache::Key key;
+                    key.data_version = audio->data_version;
+                    key.view_min = limits.X.Min;
+                    key.view_max = limits.X.Max;
+                    key.plot_pos = ImPlot::GetPlotPos();
+                    key.plot_size = ImPlot::GetPlotSize();
+                    key.scale = peak;
+                    ImDrawList* drawList = ImPlot::GetPlotDrawList();
+                    ImPlot::PushPlotClipRect();
+                    //The preview changes as pages or samples are decoded, it is never cached
+                    bool cacheable = knownPeak && !previewing;
+                    ChannelGeometry& geometry = waveform_cache[c];
+                    bool cached = cacheable && geometry.cache.draw(drawList, key);
+                    ImPlot::PopPlotClipRect();
+                    if (!cached)
+                    {
+                        geometry.cache.beginRecording(drawList);
+                        geometry.coarsened = plotWaveform(*audio, c, viewEnd, channelVertices);
+                        if (cacheable)
+                            geometry.cache.endRecording(drawList, key);
+                    }
+                    over_budget |= geometry.coarsened;
+                    showCursorTime(wave.sample_rate);
+                    ImPlot::EndPlot();
                 }
-
-
+                ImPlot::EndSubplots();
             }
             ImGui::End();
+            reset_view = false;
 
             //Set partner window size and position
             ImGui::SetNextWindowSize(ImVec2((displayX * 2  * 0.10), displayY), ImGuiCond_Always);
@@ -367,16 +541,87 @@ int main()
                 ImGui::Text("Byte Rate:\n%i", wave.byte_rate);
                 ImGui::Text("Bytes Per Sample:\n%i", wave.block_align);
                 ImGui::Text("Bits Per Sample:\n%i", wave.bits_per_sample);
-                ImGui::Text("Number of Samples:\n%i", wave.number_of_samples);
+                if (wave.valid_bits_per_sample != 0)
+                    ImGui::Text("Extensible Sub-Format:\n%i (%i valid bits)", wave.sub_format, wave.valid_bits_per_sample);
+                ImGui::Text("Number of Samples:\n%llu", wave.number_of_samples);
                 ImGui::Text("Duration (s):\n%f", wave.duration);
+                if (audio->overview_ready && !wave.channel_stats.empty())
+                {
+                    //Measured while decoding, in raw sample units
+                    ImGui::Text("Max Amplitude:\n%g", wave.max_amplitude);
+                    for (size_t c = 0; c < wave.channel_stats.size(); c++)
+                    {
+                        const ChannelStats& stats = wave.channel_stats[c];
+                        char label[32];
+                        snprintf(label, sizeof(label), "Channel %d Statistics", static_cast<int>(c) + 1);
+                        if (ImGui::TreeNode(label))
+                        {
+                            ImGui::Text("Peak: %g", stats.peak());
+                            ImGui::Text("Min: %g", stats.min);
+                            ImGui::Text("Max: %g", stats.max);
+                            ImGui::Text("RMS: %.2f", stats.rms());
+                            ImGui::Text("DC Offset: %.3f", stats.dcOffset());
+                            ImGui::Text("Clipped: %llu", stats.clipped);
+                            ImGui::TreePop();
+                        }
+                    }
+                }
+                if (audio->overview_only)
+                {
+                    ImGui::Text("Sample Memory (MB):\n0 (overview only,\nfile too large)");
+                    if (audio->pages)
+                        ImGui::Text("Page Cache (MB):\n%.1f / %.1f", audio->pages->bytes() / (1024.0 * 1024.0), audio->pages->budget() / (1024.0 * 1024.0));
+                }
+                else if (!previewing)
+                {
+                    ImGui::Text("Sample Memory (MB):\n%.1f", audio->samples.bytes() / (1024.0 * 1024.0));
+                    ImGui::Text("Peak Saved By\nPreallocating (MB):\n%.1f", audio->preallocation_saved_bytes / (1024.0 * 1024.0));
+                }
+                //The frame count stands still while the window is idle
+                ImGui::Text("Last Frame:\n%i vertices\n%i draw calls", frame_vertices, frame_draw_calls);
+                ImGui::Text("Frames Drawn:\n%llu", scheduler.framesDrawn());
+                if (over_budget)
+                    ImGui::TextDisabled("Waveform coarsened to\nstay in vertex budget");
                 ImGui::Spacing();
                 ImGui::Spacing();
-                ImGui::Text("Return To File Select");
-                if (ImGui::Button("Return"))
-                {   
-                    is_file_open = false;
-                    file_name = "";
-                    wave.reset();
+                if (previewing)
+                {
+                    //Still building the overview, only the first seconds are shown. Files with a peak file are
+                    //already shown whole, only their samples are still decoding.
+                    ImGui::Text(audio->overview_ready ? "Decoding Samples" : "Building Overview");
+                    ImGui::ProgressBar(loader.progress(), ImVec2(-1.0f, 0.0f));
+                    if (ImGui::Button("Cancel"))
+                    {
+                        load_cancelled = true;
+                        loader.cancel();
+                    }
+                }
+                else
+                {
+                    //Files still being recorded keep growing on screen
+                    if (!audio->overview_only)
+                    {
+                        bool following = follower.isFollowing();
+                        if (ImGui::Checkbox("Follow", &following))
+                        {
+                            if (following)
+                                follower.start(*audio);
+                            else
+                                follower.stop();
+                        }
+                        ImGui::SameLine(); helpMarker(
+                            "Keep reading frames appended to the file while it is\nbeing recorded and scroll to show the newest ones.\n");
+                        ImGui::Spacing();
+                    }
+
+                    ImGui::Text("Return To File Select");
+                    if (ImGui::Button("Return"))
+                    {   
+                        follower.stop();
+                        is_file_open = false;
+                        file_name = "";
+                        loaded_audio.reset();
+                    }
                 }
             
 
@@ -387,9 +632,16 @@ int main()
         //Input File Window
         else
         {
-            //Set input file window size and position
+            reset_view = true;
+
+            //Browser for whole folders on the left
+            std::string library_pick;
+            bool library_picked = drawLibraryWindow(library_pick);
+
+            //Set input file window size and position, centered in the space right of the library
+            float libraryWidth = displayX * 0.65f;
             ImGui::SetNextWindowSize(ImVec2(displayX / 2, displayY/4), ImGuiCond_Once);
-            ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x * 0.5f, ImGui::GetIO().DisplaySize.y * 0.5f), ImGuiCond_Once, ImVec2(0.5f, 0.5f));
+            ImGui::SetNextWindowPos(ImVec2((libraryWidth + ImGui::GetIO().DisplaySize.x) * 0.5f, ImGui::GetIO().DisplaySize.y * 0.5f), ImGuiCond_Once, ImVec2(0.5f, 0.5f));
 
             //Display input file window
             ImGui::Begin("InputWindow");
@@ -401,47 +653,78 @@ int main()
                     "Path relative to exe or solution directory.\n");
                 ImGui::Spacing();
 
+                //Loading runs in the background, only one file at a time
+                bool start_load = false;
+                std::string load_name;
+                ImGui::BeginDisabled(loader.isLoading());
                 if (ImGui::Button("Submit")) {
-                    if (readFile(file_name_buffer, wave) == 0) {
-                        is_file_open = true;
-                        failed_to_load = false;
-                    }
-                    else
-                    {
-                        failed_to_load = true;
-                    }
+                    start_load = true;
+                    load_name = file_name_buffer;
                 }
 
                 ImGui::SameLine();
                 if(failed_to_load)
                     ImGui::Text("Failed to load. Check the file path and try again.");
+                else if (load_cancelled)
+                    ImGui::Text("Loading cancelled.");
 
                 //Some shortcuts for easier testing
                 ImGui::Spacing();
                 ImGui::Text("Shortcuts");
                 if (ImGui::Button("audio1.wav")) {
-                    if (readFile("test samples/Q1/audio1.wav", wave) == 0) {
-                        file_name = "test samples/Q1/audio1.wav";
-                        is_file_open = true;
-                        failed_to_load = false;
-                    }
-                    else
-                    {
-                        failed_to_load = true;
-                    }
+                    start_load = true;
+                    load_name = "test samples/Q1/audio1.wav";
                 }
 
                 ImGui::SameLine();
                 if (ImGui::Button("audio2.wav"))
                 {
-                    if (readFile("test samples/Q1/audio2.wav", wave) == 0) {
-                        file_name = "test samples/Q1/audio2.wav";
-                        is_file_open = true;
-                        failed_to_load = false;
-                    }
-                    else
+                    start_load = true;
+                    load_name = "test samples/Q1/audio2.wav";
+                }
+                ImGui::EndDisabled();
+
+                //A file double clicked in the library browser
+                if (library_picked && !loader.isLoading())
+                {
+                    start_load = true;
+                    load_name = library_pick;
+                    snprintf(file_name_buffer, sizeof(file_name_buffer), "%s", library_pick.c_str());
+                }
+
+                //Storage option for the next load
+                ImGui::Spacing();
+                ImGui::Checkbox("Compact Samples", &load_options.compact_samples);
+                ImGui::SameLine(); helpMarker(
+                    "Keep samples at the bit depth of the file instead of\nconverting them to float. Halves memory for 16-bit files.\n");
+
+                //Also applied to the file on screen, its cache drops pages right away if it is now over
+                int page_cache_mb = static_cast<int>(load_options.page_cache_budget >> 20);
+                if (ImGui::SliderInt("Page Cache (MB)", &page_cache_mb, 16, 4096, "%d", ImGuiSliderFlags_Logarithmic))
+                {
+                    load_options.page_cache_budget = static_cast<size_t>(page_cache_mb) << 20;
+                    if (audio && audio->pages)
+                        audio->pages->setBudget(load_options.page_cache_budget);
+                }
+                ImGui::SameLine(); helpMarker(
+                    "Memory for decoded close-ups of files too large\nto hold in memory. Older pages are dropped first.\n");
+
+                if (start_load)
+                {
+                    failed_to_load = false;
+                    load_cancelled = false;
+                    loader.start(load_name, load_options);
+                }
+
+                //Progress of the running load (bytes decoded / subchunk2 size)
+                if (loader.isLoading())
+                {
+                    ImGui::Spacing();
+                    ImGui::ProgressBar(loader.progress(), ImVec2(-1.0f, 0.0f));
+                    if (ImGui::Button("Cancel"))
                     {
-                        failed_to_load = true;
+                        load_cancelled = true;
+                        loader.cancel();
                     }
                 }
                 
@@ -453,12 +736,19 @@ int main()
         // Rendering
         ImGui::Render();
 
-
+        //Counted here, shown next frame
+        ImDrawData* drawData = ImGui::GetDrawData();
+        frame_vertices = drawData->TotalVtxCount;
+        frame_draw_calls = 0;
+        for (int i = 0; i < drawData->CmdListsCount; i++)
+            frame_draw_calls += drawData->CmdLists[i]->CmdBuffer.Size;
 
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
-        glfwPollEvents();
+
+        //Sleep until input, a window change or background work needs the next frame
+        scheduler.waitForNextFrame();
     }
     //Cleanup and close program
     cleanup();
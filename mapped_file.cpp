@@ -0,0 +1,130 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& fileName, MapAccess access)
+{
+    close();
+
+    DWORD flags = FILE_ATTRIBUTE_NORMAL | (access == MapAccess::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS);
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    file_size = static_cast<size_t>(size.QuadPart);
+    is_open = true;
+
+    //Zero length files cannot be mapped, treat them as an open but empty view
+    if (file_size == 0)
+        return true;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        close();
+        return false;
+    }
+    mapping_handle = mapping;
+
+    view = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (view == nullptr)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (view != nullptr)
+        UnmapViewOfFile(view);
+    if (mapping_handle != nullptr)
+        CloseHandle(static_cast<HANDLE>(mapping_handle));
+    if (file_handle != nullptr)
+        CloseHandle(static_cast<HANDLE>(file_handle));
+
+    view = nullptr;
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+    file_size = 0;
+    is_open = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& fileName, MapAccess access)
+{
+    close();
+
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    file_descriptor = fd;
+    file_size = static_cast<size_t>(info.st_size);
+    is_open = true;
+
+    //Zero length files cannot be mapped, treat them as an open but empty view
+    if (file_size == 0)
+        return true;
+
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    //Samples are decoded front to back, let the kernel read ahead aggressively. Header reads only want the
+    //pages they touch.
+    madvise(mapping, file_size, access == MapAccess::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    view = static_cast<const unsigned char*>(mapping);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (view != nullptr)
+        munmap(const_cast<unsigned char*>(view), file_size);
+    if (file_descriptor >= 0)
+        ::close(file_descriptor);
+
+    view = nullptr;
+    file_descriptor = -1;
+    file_size = 0;
+    is_open = false;
+}
+
+#endif
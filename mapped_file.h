@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstring>
+
+//Read-only view of a byte range inside a mapped file. Nothing is copied, the pointer is only valid while the
+//owning MappedFile stays open.
+struct ByteSpan {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+    //Clamp the requested range to the bytes that actually exist
+    ByteSpan subspan(size_t offset, size_t length) const
+    {
+        ByteSpan result;
+        if (offset >= size)
+            return result;
+        result.data = data + offset;
+        result.size = (length < size - offset) ? length : size - offset;
+        return result;
+    }
+
+    //Unaligned little-endian read of a value at "offset". WAV chunks are only 2-byte aligned, so the
+    //reinterpret_cast approach is not safe here.
+    template <typename T>
+    T read(size_t offset) const
+    {
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+};
+
+//How the mapped bytes will be read, passed on to the OS read-ahead
+enum class MapAccess {
+    Sequential,     //Decoding front to back, read ahead aggressively
+    Random          //Only a few spots are read (headers, single pages), read nothing extra
+};
+
+//Whole-file read-only memory mapping (MapViewOfFile on Windows, mmap elsewhere). Loading is then limited by how
+//fast the OS can page the file in instead of by stream calls per sample frame.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //Returns false if the file cannot be opened or mapped. Empty files open successfully with size() == 0.
+    bool open(const std::string& fileName, MapAccess access = MapAccess::Sequential);
+    void close();
+
+    bool isOpen() const { return is_open; }
+    const unsigned char* data() const { return view; }
+    size_t size() const { return file_size; }
+    ByteSpan bytes() const { ByteSpan span; span.data = view; span.size = file_size; return span; }
+
+private:
+    bool is_open = false;
+    const unsigned char* view = nullptr;
+    size_t file_size = 0;
+
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int file_descriptor = -1;
+#endif
+};
@@ -0,0 +1,117 @@
+#include "page_cache.h"
+
+#include <algorithm>
+
+PageCache::PageCache(const WaveReader& reader, size_t budgetBytes, size_t pageFrames)
+    : source(reader)
+{
+    channel_count = reader.channelCount();
+    frame_count = reader.frameCount();
+    page_frames = (pageFrames > 0) ? pageFrames : defaultPageFrames;
+    page_count = (frame_count + page_frames - 1) / page_frames;
+    budget_bytes = budgetBytes;
+}
+
+void PageCache::setBudget(size_t budgetBytes)
+{
+    budget_bytes = budgetBytes;
+    evict(0);
+}
+
+void PageCache::clear()
+{
+    pages.clear();
+    lru.clear();
+}
+
+void PageCache::evict(size_t keepPages)
+{
+    //Make room for "keepPages" more pages without going over the budget, but never drop everything
+    size_t pageLimit = std::max<size_t>(budget_bytes / std::max<size_t>(pageBytes(), 1), 1);
+    while (!lru.empty() && pages.size() + keepPages > pageLimit)
+    {
+        pages.erase(lru.back());
+        lru.pop_back();
+    }
+}
+
+const float* PageCache::channelPage(size_t index, int channel)
+{
+    if (index >= page_count || channel < 0 || channel >= channel_count)
+        return nullptr;
+
+    auto found = pages.find(index);
+    if (found != pages.end())
+    {
+        hit_count++;
+        lru.splice(lru.begin(), lru, found->second.lru_position);
+        return found->second.samples.data() + page_frames * channel;
+    }
+
+    //Miss: make room first so the cache never holds more than its budget, then decode the whole page
+    miss_count++;
+    evict(1);
+    lru.push_front(index);
+    Page& page = pages[index];
+    page.lru_position = lru.begin();
+    page.samples.resize(page_frames * channel_count);
+
+    std::vector<float*> channels(channel_count);
+    for (int c = 0; c < channel_count; c++)
+        channels[c] = page.samples.data() + page_frames * c;
+    source.readFramesAt(index * page_frames, channels.data(), page_frames);
+    return page.samples.data() + page_frames * channel;
+}
+
+void PageCache::scan(int channel, size_t first, size_t last, float& lo, float& hi)
+{
+    while (first < last)
+    {
+        size_t index = first / page_frames;
+        const float* page = channelPage(index, channel);
+        if (page == nullptr)
+            return;
+
+        size_t pageEnd = std::min((index + 1) * page_frames, last);
+        const float* begin = page + (first - index * page_frames);
+        const float* end = page + (pageEnd - index * page_frames);
+        lo = std::min(lo, *std::min_element(begin, end));
+        hi = std::max(hi, *std::max_element(begin, end));
+        first = pageEnd;
+    }
+}
+
+size_t PageCache::query(int channel, size_t start, size_t end, size_t columns,
+                        std::vector<float>& out_min, std::vector<float>& out_max)
+{
+    out_min.clear();
+    out_max.clear();
+    end = std::min(end, frame_count);
+    if (start >= end || columns == 0 || channel < 0 || channel >= channel_count)
+        return 0;
+
+    size_t count = end - start;
+    columns = std::min(columns, count);
+    double samplesPerColumn = static_cast<double>(count) / static_cast<double>(columns);
+    out_min.resize(columns);
+    out_max.resize(columns);
+    for (size_t c = 0; c < columns; c++)
+    {
+        size_t first = start + static_cast<size_t>(c * samplesPerColumn);
+        size_t last = std::min(start + static_cast<size_t>((c + 1) * samplesPerColumn), end);
+        if (last <= first)
+            last = first + 1;
+
+        float lo = 0.0f;
+        float hi = 0.0f;
+        const float* page = channelPage(first / page_frames, channel);
+        if (page != nullptr)
+        {
+            lo = hi = page[first % page_frames];
+            scan(channel, first, last, lo, hi);
+        }
+        out_min[c] = lo;
+        out_max[c] = hi;
+    }
+    return columns;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "wave_reader.h"
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+//Decoded samples of a WaveReader, kept as fixed-size pages of frames. A page is decoded the first time any of
+//its frames is asked for and the least recently used pages are dropped once the cache grows past its budget, so
+//only the part of the file the view actually touches is ever decoded. Not thread-safe, meant to be used from
+//the render thread only.
+class PageCache {
+public:
+    static const size_t defaultPageFrames = 1 << 16;
+    static const size_t defaultBudgetBytes = 256ull << 20;
+
+    //"reader" must stay open for as long as the cache is used
+    explicit PageCache(const WaveReader& reader, size_t budgetBytes = defaultBudgetBytes,
+                       size_t pageFrames = defaultPageFrames);
+
+    PageCache(const PageCache&) = delete;
+    PageCache& operator=(const PageCache&) = delete;
+
+    //Change the budget, evicting pages right away if the cache is now over it. At least one page is always kept.
+    void setBudget(size_t budgetBytes);
+    size_t budget() const { return budget_bytes; }
+    void clear();
+
+    size_t pageFrames() const { return page_frames; }
+    size_t pageCount() const { return page_count; }
+    size_t cachedPages() const { return pages.size(); }
+    size_t bytes() const { return pages.size() * pageBytes(); }
+    unsigned long long hits() const { return hit_count; }
+    unsigned long long misses() const { return miss_count; }
+
+    //Samples of "channel" in page "index" (frames index * pageFrames() onwards), decoding the page on a miss.
+    //Returns nullptr past the end of the file. The pointer is only valid until the next call into the cache.
+    const float* channelPage(size_t index, int channel);
+
+    //Same contract as WaveformLod::query(): reduce frames [start, end) of "channel" to at most "columns" min/max
+    //pairs, decoding only the pages that range covers. Returns the number of columns written.
+    size_t query(int channel, size_t start, size_t end, size_t columns,
+                 std::vector<float>& out_min, std::vector<float>& out_max);
+
+private:
+    struct Page {
+        std::list<size_t>::iterator lru_position;
+        std::vector<float> samples;         //Planar, page_frames floats per channel
+    };
+
+    size_t pageBytes() const { return page_frames * channel_count * sizeof(float); }
+    void evict(size_t keepPages);
+    //Lowest and highest sample of "channel" in frames [first, last)
+    void scan(int channel, size_t first, size_t last, float& lo, float& hi);
+
+    const WaveReader& source;
+    int channel_count = 0;
+    size_t frame_count = 0;
+    size_t page_frames = 0;
+    size_t page_count = 0;
+    size_t budget_bytes = 0;
+
+    //Most recently used page index first
+    std::list<size_t> lru;
+    std::unordered_map<size_t, Page> pages;
+
+    unsigned long long hit_count = 0;
+    unsigned long long miss_count = 0;
+};
@@ -0,0 +1,519 @@
+#include "pcm_decode.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define PCM_DECODE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PCM_DECODE_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//GCC and Clang only emit AVX2 instructions inside functions marked for it, MSVC needs no annotation
+#if defined(__GNUC__) || defined(__clang__)
+#define PCM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PCM_TARGET_AVX2
+#endif
+
+size_t pcmBytesPerSample(PcmFormat format)
+{
+    switch (format)
+    {
+        case PcmFormat::UInt8: return 1;
+        case PcmFormat::Int16: return 2;
+        case PcmFormat::Int24: return 3;
+        case PcmFormat::Int32: return 4;
+        case PcmFormat::Float32: return 4;
+        case PcmFormat::Float64: return 8;
+    }
+    return 0;
+}
+
+//Scalar kernels. Also used for the tail of every vector loop.
+
+template <PcmFormat F>
+static inline float loadSample(const unsigned char* p);
+
+template <>
+inline float loadSample<PcmFormat::UInt8>(const unsigned char* p)
+{
+    return static_cast<float>(static_cast<int>(p[0]) - 128);
+}
+
+template <>
+inline float loadSample<PcmFormat::Int16>(const unsigned char* p)
+{
+    int16_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return static_cast<float>(value);
+}
+
+template <>
+inline float loadSample<PcmFormat::Int24>(const unsigned char* p)
+{
+    //Little-endian, place the 3 bytes at the top of an int32 and shift back down to sign extend
+    uint32_t bits = (static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 24);
+    return static_cast<float>(static_cast<int32_t>(bits) >> 8);
+}
+
+template <>
+inline float loadSample<PcmFormat::Int32>(const unsigned char* p)
+{
+    int32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return static_cast<float>(value);
+}
+
+template <>
+inline float loadSample<PcmFormat::Float32>(const unsigned char* p)
+{
+    float value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+template <>
+inline float loadSample<PcmFormat::Float64>(const unsigned char* p)
+{
+    double value;
+    std::memcpy(&value, p, sizeof(value));
+    return static_cast<float>(value);
+}
+
+template <PcmFormat F>
+static void decodeMonoScalar(const unsigned char* src, size_t frames, float* out)
+{
+    const size_t width = pcmBytesPerSample(F);
+    for (size_t f = 0; f < frames; f++)
+        out[f] = loadSample<F>(src + f * width);
+}
+
+template <PcmFormat F>
+static void decodeStereoScalar(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    const size_t width = pcmBytesPerSample(F);
+    for (size_t f = 0; f < frames; f++)
+    {
+        left[f] = loadSample<F>(src + f * width * 2);
+        right[f] = loadSample<F>(src + f * width * 2 + width);
+    }
+}
+
+template <PcmFormat F>
+static void decodeGenericScalar(const unsigned char* src, size_t frames, int channels, float* const* out)
+{
+    const size_t width = pcmBytesPerSample(F);
+    for (size_t f = 0; f < frames; f++)
+    {
+        const unsigned char* frame = src + f * width * channels;
+        for (int c = 0; c < channels; c++)
+            out[c][f] = loadSample<F>(frame + c * width);
+    }
+}
+
+#ifdef PCM_DECODE_SSE2
+
+//SSE2 kernels. Packed 24-bit needs a byte shuffle (SSSE3), so Int24 stays on the scalar kernel at this level.
+
+//Widen 8 unsigned bytes to signed 16-bit lanes centred on 0
+static inline __m128i centreUInt8x8(__m128i bytes)
+{
+    return _mm_sub_epi16(_mm_unpacklo_epi8(bytes, _mm_setzero_si128()), _mm_set1_epi16(128));
+}
+
+static void decodeMonoUInt8SSE2(const unsigned char* src, size_t frames, float* out)
+{
+    size_t f = 0;
+    for (; f + 16 <= frames; f += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + f));
+        __m128i words[2] = { centreUInt8x8(v), centreUInt8x8(_mm_srli_si128(v, 8)) };
+        for (int w = 0; w < 2; w++)
+        {
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(words[w], words[w]), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(words[w], words[w]), 16);
+            _mm_storeu_ps(out + f + w * 8, _mm_cvtepi32_ps(lo));
+            _mm_storeu_ps(out + f + w * 8 + 4, _mm_cvtepi32_ps(hi));
+        }
+    }
+    decodeMonoScalar<PcmFormat::UInt8>(src + f, frames - f, out + f);
+}
+
+static void decodeMonoInt16SSE2(const unsigned char* src, size_t frames, float* out)
+{
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + f * 2));
+        //Duplicate each sample into both halves of a 32-bit lane, then arithmetic shift to sign extend
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + f, _mm_cvtepi32_ps(lo));
+        _mm_storeu_ps(out + f + 4, _mm_cvtepi32_ps(hi));
+    }
+    decodeMonoScalar<PcmFormat::Int16>(src + f * 2, frames - f, out + f);
+}
+
+static void decodeMonoInt32SSE2(const unsigned char* src, size_t frames, float* out)
+{
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + f * 4));
+        _mm_storeu_ps(out + f, _mm_cvtepi32_ps(v));
+    }
+    decodeMonoScalar<PcmFormat::Int32>(src + f * 4, frames - f, out + f);
+}
+
+static void decodeMonoFloat32(const unsigned char* src, size_t frames, float* out)
+{
+    std::memcpy(out, src, frames * sizeof(float));
+}
+
+static void decodeMonoFloat64SSE2(const unsigned char* src, size_t frames, float* out)
+{
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 a = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(src + f * 8)));
+        __m128 b = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(src + f * 8 + 16)));
+        _mm_storeu_ps(out + f, _mm_movelh_ps(a, b));
+    }
+    decodeMonoScalar<PcmFormat::Float64>(src + f * 8, frames - f, out + f);
+}
+
+static void decodeStereoUInt8SSE2(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        //Four frames widened to 16 bits, each 32-bit lane then holds one frame like the Int16 kernel
+        __m128i v = centreUInt8x8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + f * 2)));
+        __m128i l = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+        __m128i r = _mm_srai_epi32(v, 16);
+        _mm_storeu_ps(left + f, _mm_cvtepi32_ps(l));
+        _mm_storeu_ps(right + f, _mm_cvtepi32_ps(r));
+    }
+    decodeStereoScalar<PcmFormat::UInt8>(src + f * 2, frames - f, left + f, right + f);
+}
+
+static void decodeStereoInt16SSE2(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        //Each 32-bit lane holds one frame: left in the low half, right in the high half
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + f * 4));
+        __m128i l = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+        __m128i r = _mm_srai_epi32(v, 16);
+        _mm_storeu_ps(left + f, _mm_cvtepi32_ps(l));
+        _mm_storeu_ps(right + f, _mm_cvtepi32_ps(r));
+    }
+    decodeStereoScalar<PcmFormat::Int16>(src + f * 4, frames - f, left + f, right + f);
+}
+
+static void decodeStereoInt32SSE2(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 a = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + f * 8)));
+        __m128 b = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + f * 8 + 16)));
+        _mm_storeu_ps(left + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    decodeStereoScalar<PcmFormat::Int32>(src + f * 8, frames - f, left + f, right + f);
+}
+
+static void decodeStereoFloat32SSE2(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 a = _mm_loadu_ps(reinterpret_cast<const float*>(src + f * 8));
+        __m128 b = _mm_loadu_ps(reinterpret_cast<const float*>(src + f * 8 + 16));
+        _mm_storeu_ps(left + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    decodeStereoScalar<PcmFormat::Float32>(src + f * 8, frames - f, left + f, right + f);
+}
+
+static void decodeStereoFloat64SSE2(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        //One frame per 128-bit load, converted pairs are packed back into L R L R order
+        const double* p = reinterpret_cast<const double*>(src + f * 16);
+        __m128 a = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2)));
+        __m128 b = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p + 4)), _mm_cvtpd_ps(_mm_loadu_pd(p + 6)));
+        _mm_storeu_ps(left + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    decodeStereoScalar<PcmFormat::Float64>(src + f * 16, frames - f, left + f, right + f);
+}
+
+#endif
+
+#ifdef PCM_DECODE_AVX2
+
+//AVX2 kernels
+
+//Two 128-bit loads 12 bytes apart, each lane then holds four packed 24-bit samples plus 4 bytes of slack
+PCM_TARGET_AVX2 static inline __m256i loadInt24x8(const unsigned char* p)
+{
+    const __m256i spread = _mm256_setr_epi8(
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    __m256i raw = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+    //Move each sample into the top 3 bytes of its 32-bit lane, then shift down to sign extend
+    return _mm256_srai_epi32(_mm256_shuffle_epi8(raw, spread), 8);
+}
+
+PCM_TARGET_AVX2 static void decodeMonoInt16AVX2(const unsigned char* src, size_t frames, float* out)
+{
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8)
+    {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + f * 2)));
+        _mm256_storeu_ps(out + f, _mm256_cvtepi32_ps(v));
+    }
+    decodeMonoScalar<PcmFormat::Int16>(src + f * 2, frames - f, out + f);
+}
+
+PCM_TARGET_AVX2 static void decodeMonoInt24AVX2(const unsigned char* src, size_t frames, float* out)
+{
+    size_t f = 0;
+    //The second load reads 4 bytes past the 8 samples, so keep 2 samples of headroom
+    for (; f + 10 <= frames; f += 8)
+        _mm256_storeu_ps(out + f, _mm256_cvtepi32_ps(loadInt24x8(src + f * 3)));
+    decodeMonoScalar<PcmFormat::Int24>(src + f * 3, frames - f, out + f);
+}
+
+PCM_TARGET_AVX2 static void decodeMonoInt32AVX2(const unsigned char* src, size_t frames, float* out)
+{
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + f * 4));
+        _mm256_storeu_ps(out + f, _mm256_cvtepi32_ps(v));
+    }
+    decodeMonoScalar<PcmFormat::Int32>(src + f * 4, frames - f, out + f);
+}
+
+PCM_TARGET_AVX2 static void decodeStereoInt16AVX2(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + f * 4));
+        __m256i l = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+        __m256i r = _mm256_srai_epi32(v, 16);
+        _mm256_storeu_ps(left + f, _mm256_cvtepi32_ps(l));
+        _mm256_storeu_ps(right + f, _mm256_cvtepi32_ps(r));
+    }
+    decodeStereoScalar<PcmFormat::Int16>(src + f * 4, frames - f, left + f, right + f);
+}
+
+PCM_TARGET_AVX2 static void decodeStereoInt24AVX2(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    //Gather the even (left) lanes into the low half and the odd (right) lanes into the high half
+    const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    size_t f = 0;
+    for (; f + 5 <= frames; f += 4)
+    {
+        __m256 v = _mm256_cvtepi32_ps(_mm256_permutevar8x32_epi32(loadInt24x8(src + f * 6), split));
+        _mm_storeu_ps(left + f, _mm256_castps256_ps128(v));
+        _mm_storeu_ps(right + f, _mm256_extractf128_ps(v, 1));
+    }
+    decodeStereoScalar<PcmFormat::Int24>(src + f * 6, frames - f, left + f, right + f);
+}
+
+//a = L0 R0 L1 R1 | L2 R2 L3 R3, b = L4 R4 L5 R5 | L6 R6 L7 R7
+PCM_TARGET_AVX2 static inline void splitStereoAVX2(__m256 a, __m256 b, float* left, float* right)
+{
+    //In-lane shuffles give L0 L1 L4 L5 | L2 L3 L6 L7, then reorder the 64-bit pairs
+    __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    l = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0)));
+    r = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm256_storeu_ps(left, l);
+    _mm256_storeu_ps(right, r);
+}
+
+PCM_TARGET_AVX2 static void decodeStereoInt32AVX2(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8)
+    {
+        __m256 a = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + f * 8)));
+        __m256 b = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + f * 8 + 32)));
+        splitStereoAVX2(a, b, left + f, right + f);
+    }
+    decodeStereoScalar<PcmFormat::Int32>(src + f * 8, frames - f, left + f, right + f);
+}
+
+PCM_TARGET_AVX2 static void decodeStereoFloat32AVX2(const unsigned char* src, size_t frames, float* left, float* right)
+{
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8)
+    {
+        __m256 a = _mm256_loadu_ps(reinterpret_cast<const float*>(src + f * 8));
+        __m256 b = _mm256_loadu_ps(reinterpret_cast<const float*>(src + f * 8 + 32));
+        splitStereoAVX2(a, b, left + f, right + f);
+    }
+    decodeStereoScalar<PcmFormat::Float32>(src + f * 8, frames - f, left + f, right + f);
+}
+
+static bool cpuHasAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    //AVX state must also be enabled by the OS (OSXSAVE + XCR0 bits for XMM/YMM)
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+//Runtime dispatch, indexed by PcmFormat
+
+typedef void (*MonoKernel)(const unsigned char*, size_t, float*);
+typedef void (*StereoKernel)(const unsigned char*, size_t, float*, float*);
+
+struct KernelTable {
+    const char* name;
+    MonoKernel mono[pcmFormatCount];
+    StereoKernel stereo[pcmFormatCount];
+};
+
+static KernelTable selectKernels()
+{
+    KernelTable table = {
+        "Scalar",
+        { decodeMonoScalar<PcmFormat::UInt8>, decodeMonoScalar<PcmFormat::Int16>, decodeMonoScalar<PcmFormat::Int24>,
+          decodeMonoScalar<PcmFormat::Int32>, decodeMonoScalar<PcmFormat::Float32>, decodeMonoScalar<PcmFormat::Float64> },
+        { decodeStereoScalar<PcmFormat::UInt8>, decodeStereoScalar<PcmFormat::Int16>, decodeStereoScalar<PcmFormat::Int24>,
+          decodeStereoScalar<PcmFormat::Int32>, decodeStereoScalar<PcmFormat::Float32>, decodeStereoScalar<PcmFormat::Float64> }
+    };
+
+#ifdef PCM_DECODE_SSE2
+    table.name = "SSE2";
+    table.mono[static_cast<int>(PcmFormat::UInt8)] = decodeMonoUInt8SSE2;
+    table.mono[static_cast<int>(PcmFormat::Float64)] = decodeMonoFloat64SSE2;
+    table.stereo[static_cast<int>(PcmFormat::UInt8)] = decodeStereoUInt8SSE2;
+    table.stereo[static_cast<int>(PcmFormat::Float64)] = decodeStereoFloat64SSE2;
+    table.mono[static_cast<int>(PcmFormat::Int16)] = decodeMonoInt16SSE2;
+    table.mono[static_cast<int>(PcmFormat::Int32)] = decodeMonoInt32SSE2;
+    table.mono[static_cast<int>(PcmFormat::Float32)] = decodeMonoFloat32;
+    table.stereo[static_cast<int>(PcmFormat::Int16)] = decodeStereoInt16SSE2;
+    table.stereo[static_cast<int>(PcmFormat::Int32)] = decodeStereoInt32SSE2;
+    table.stereo[static_cast<int>(PcmFormat::Float32)] = decodeStereoFloat32SSE2;
+#endif
+
+#ifdef PCM_DECODE_AVX2
+    if (cpuHasAvx2())
+    {
+        table.name = "AVX2";
+        table.mono[static_cast<int>(PcmFormat::Int16)] = decodeMonoInt16AVX2;
+        table.mono[static_cast<int>(PcmFormat::Int24)] = decodeMonoInt24AVX2;
+        table.mono[static_cast<int>(PcmFormat::Int32)] = decodeMonoInt32AVX2;
+        table.stereo[static_cast<int>(PcmFormat::Int16)] = decodeStereoInt16AVX2;
+        table.stereo[static_cast<int>(PcmFormat::Int24)] = decodeStereoInt24AVX2;
+        table.stereo[static_cast<int>(PcmFormat::Int32)] = decodeStereoInt32AVX2;
+        table.stereo[static_cast<int>(PcmFormat::Float32)] = decodeStereoFloat32AVX2;
+    }
+#endif
+
+    return table;
+}
+
+static const KernelTable& kernels()
+{
+    //Chosen once, the first time anything is decoded
+    static const KernelTable table = selectKernels();
+    return table;
+}
+
+const char* pcmKernelName()
+{
+    return kernels().name;
+}
+
+void decodeInterleaved(PcmFormat format, const unsigned char* src, size_t frames, int channels, float* const* out)
+{
+    if (frames == 0 || channels <= 0)
+        return;
+
+    const KernelTable& table = kernels();
+    int index = static_cast<int>(format);
+    if (channels == 1)
+    {
+        table.mono[index](src, frames, out[0]);
+        return;
+    }
+    if (channels == 2)
+    {
+        table.stereo[index](src, frames, out[0], out[1]);
+        return;
+    }
+
+    switch (format)
+    {
+        case PcmFormat::UInt8: decodeGenericScalar<PcmFormat::UInt8>(src, frames, channels, out); break;
+        case PcmFormat::Int16: decodeGenericScalar<PcmFormat::Int16>(src, frames, channels, out); break;
+        case PcmFormat::Int24: decodeGenericScalar<PcmFormat::Int24>(src, frames, channels, out); break;
+        case PcmFormat::Int32: decodeGenericScalar<PcmFormat::Int32>(src, frames, channels, out); break;
+        case PcmFormat::Float32: decodeGenericScalar<PcmFormat::Float32>(src, frames, channels, out); break;
+        case PcmFormat::Float64: decodeGenericScalar<PcmFormat::Float64>(src, frames, channels, out); break;
+    }
+}
+
+//Native-width deinterleave, a fixed sample width lets the compiler turn the copies into plain loads and stores
+template <size_t Width>
+static void splitScalar(const unsigned char* src, size_t frames, int channels, unsigned char* const* out)
+{
+    const size_t frameBytes = Width * channels;
+    for (size_t f = 0; f < frames; f++)
+    {
+        const unsigned char* frame = src + f * frameBytes;
+        for (int c = 0; c < channels; c++)
+            std::memcpy(out[c] + f * Width, frame + c * Width, Width);
+    }
+}
+
+void splitInterleaved(PcmFormat format, const unsigned char* src, size_t frames, int channels, unsigned char* const* out)
+{
+    if (frames == 0 || channels <= 0)
+        return;
+
+    switch (pcmBytesPerSample(format))
+    {
+        case 1: splitScalar<1>(src, frames, channels, out); break;
+        case 2: splitScalar<2>(src, frames, channels, out); break;
+        case 3: splitScalar<3>(src, frames, channels, out); break;
+        case 4: splitScalar<4>(src, frames, channels, out); break;
+        case 8: splitScalar<8>(src, frames, channels, out); break;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+//Sample encodings the decode kernels understand. Integer samples keep their raw value (no normalization) to
+//match what the plots have always shown.
+enum class PcmFormat {
+    UInt8,      //Unsigned, centred on 128. Decoded to -128..127.
+    Int16,
+    Int24,      //Packed 3 byte little-endian
+    Int32,
+    Float32,
+    Float64
+};
+
+const int pcmFormatCount = 6;
+
+size_t pcmBytesPerSample(PcmFormat format);
+
+//Convert "frames" interleaved frames of "channels" channels starting at "src" into planar float buffers. out[c]
+//must have room for "frames" floats. Mono and stereo run through SSE2/AVX2 kernels picked at runtime for the
+//current CPU, other channel counts use the scalar path.
+void decodeInterleaved(PcmFormat format, const unsigned char* src, size_t frames, int channels, float* const* out);
+
+//Name of the kernel set chosen for this CPU ("AVX2", "SSE2" or "Scalar")
+const char* pcmKernelName();
+
+//Deinterleave without converting: out[c] receives the raw samples of channel c at their native width. Used when
+//samples are stored compactly, decodeInterleaved() with one channel then converts a planar run to float.
+void splitInterleaved(PcmFormat format, const unsigned char* src, size_t frames, int channels, unsigned char* const* out);
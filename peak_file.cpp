@@ -0,0 +1,341 @@
+#include "peak_file.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <climits>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(PeakFileHeader) == 64, "PeakFileHeader must stay 64 bytes");
+static_assert(sizeof(PeakFileStats) == 40, "PeakFileStats must stay 40 bytes");
+
+static const char peakFileMagic[8] = "WVPEAKS";
+
+static unsigned long long fnv1a(const unsigned char* data, size_t size, unsigned long long hash = 14695981039346656037ull)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool fileStamp(const std::string& fileName, unsigned long long& size, long long& mtime)
+{
+#ifdef _WIN32
+    struct __stat64 info;
+    if (_stat64(fileName.c_str(), &info) != 0)
+        return false;
+#else
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0)
+        return false;
+#endif
+    size = static_cast<unsigned long long>(info.st_size);
+    mtime = static_cast<long long>(info.st_mtime);
+    return true;
+}
+
+static bool makeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+std::string peakCacheDirectory()
+{
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    if (base == nullptr || *base == '\0')
+        return "";
+    std::string directory = std::string(base) + "\\WaveformVisualizer";
+#else
+    std::string directory;
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    if (xdg != nullptr && *xdg != '\0')
+        directory = xdg;
+    else if (home != nullptr && *home != '\0')
+        directory = std::string(home) + "/.cache";
+    else
+        return "";
+    makeDirectory(directory);
+    directory += "/waveform-visualizer";
+#endif
+    if (!makeDirectory(directory))
+        return "";
+    return directory;
+}
+
+std::string cacheFilePath(const std::string& fileName, const char* extension)
+{
+    std::string directory = peakCacheDirectory();
+    if (directory.empty())
+        return "";
+
+    std::string absolute = fileName;
+#ifdef _WIN32
+    char resolved[_MAX_PATH];
+    if (_fullpath(resolved, fileName.c_str(), _MAX_PATH) != nullptr)
+        absolute = resolved;
+    const char separator = '\\';
+#else
+    char resolved[PATH_MAX];
+    if (realpath(fileName.c_str(), resolved) != nullptr)
+        absolute = resolved;
+    const char separator = '/';
+#endif
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", fnv1a(reinterpret_cast<const unsigned char*>(absolute.data()), absolute.size()));
+    return directory + separator + name + extension;
+}
+
+//First level of "lod" written to a peak file, the coarsest one if all are finer than peakFileMinBucketSize
+static size_t firstStoredLevel(const WaveformLod& lod)
+{
+    const std::vector<LodLevel>& levels = lod.getLevels();
+    size_t first = 0;
+    while (first + 1 < levels.size() && levels[first].bucket_size < peakFileMinBucketSize)
+        first++;
+    return first;
+}
+
+//The header a peak file for the currently open WAV must carry
+static bool expectedHeader(const std::string& fileName, const WaveReader& reader, const std::vector<WaveformLod>& lods,
+                           PeakFileHeader& header)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, peakFileMagic, sizeof(header.magic));
+    header.version = peakFileVersion;
+    header.channel_count = static_cast<unsigned int>(reader.channelCount());
+    if (!fileStamp(fileName, header.source_size, header.source_mtime))
+        return false;
+    ByteSpan headerBytes = reader.headerBytes();
+    header.header_hash = fnv1a(headerBytes.data, headerBytes.size);
+    header.sample_count = reader.frameCount();
+    header.level_count = lods.empty() ? 0 : static_cast<unsigned int>(lods[0].getLevels().size() - firstStoredLevel(lods[0]));
+    return true;
+}
+
+//Check the header of a mapped peak file against "expected" and read its level table. "counts" receives the number
+//of buckets of each level. Returns the offset of the first array, 0 if the file is stale or truncated.
+static size_t readPeakTable(ByteSpan bytes, const PeakFileHeader& expected, std::vector<LodLevel>& shape,
+                            std::vector<size_t>& counts)
+{
+    if (bytes.size < sizeof(PeakFileHeader))
+        return 0;
+
+    //Everything but the level count has to match what the WAV looks like right now
+    PeakFileHeader header = bytes.read<PeakFileHeader>(0);
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version ||
+        header.channel_count != expected.channel_count || header.source_size != expected.source_size ||
+        header.source_mtime != expected.source_mtime || header.header_hash != expected.header_hash ||
+        header.sample_count != expected.sample_count || header.level_count == 0 || header.level_count > 64)
+        return 0;
+
+    //The level table, then check the arrays it describes are all there before touching them
+    size_t tableOffset = sizeof(PeakFileHeader);
+    size_t offset = tableOffset + header.level_count * 16;
+    shape.assign(header.level_count, LodLevel());
+    counts.assign(header.level_count, 0);
+    unsigned long long arrayBytes = 0;
+    for (unsigned int l = 0; l < header.level_count; l++)
+    {
+        if (tableOffset + l * 16 + 16 > bytes.size)
+            return 0;
+        unsigned long long bucketCount = bytes.read<unsigned long long>(tableOffset + l * 16 + 8);
+        if (bucketCount > header.sample_count)
+            return 0;
+        shape[l].bucket_size = static_cast<size_t>(bytes.read<unsigned long long>(tableOffset + l * 16));
+        counts[l] = static_cast<size_t>(bucketCount);
+        arrayBytes += bucketCount * 3 * sizeof(float);
+    }
+    if (offset + (arrayBytes + sizeof(PeakFileStats)) * header.channel_count != bytes.size)
+        return 0;
+    return offset;
+}
+
+static bool readPeakFile(const std::string& path, const PeakFileHeader& expected, std::vector<WaveformLod>& lods,
+                         std::vector<ChannelStats>& stats)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    ByteSpan bytes = file.bytes();
+    std::vector<LodLevel> shape;
+    std::vector<size_t> counts;
+    size_t offset = readPeakTable(bytes, expected, shape, counts);
+    if (offset == 0)
+        return false;
+
+    lods.assign(expected.channel_count, WaveformLod());
+    for (unsigned int c = 0; c < expected.channel_count; c++)
+    {
+        std::vector<LodLevel> levels(shape);
+        for (size_t l = 0; l < levels.size(); l++)
+        {
+            size_t count = counts[l];
+            const float* arrays = reinterpret_cast<const float*>(bytes.data + offset);
+            levels[l].min_values.assign(arrays, arrays + count);
+            levels[l].max_values.assign(arrays + count, arrays + count * 2);
+            levels[l].rms_values.assign(arrays + count * 2, arrays + count * 3);
+            offset += count * 3 * sizeof(float);
+        }
+        if (!lods[c].assign(static_cast<size_t>(expected.sample_count), std::move(levels)))
+        {
+            lods.clear();
+            return false;
+        }
+    }
+
+    //The statistics of every channel follow the last array
+    stats.assign(expected.channel_count, ChannelStats());
+    for (ChannelStats& channel : stats)
+    {
+        PeakFileStats stored = bytes.read<PeakFileStats>(offset);
+        offset += sizeof(PeakFileStats);
+        channel.min = stored.min;
+        channel.max = stored.max;
+        channel.sum = stored.sum;
+        channel.sum_squares = stored.sum_squares;
+        channel.clipped = stored.clipped;
+        channel.count = stored.count;
+    }
+    return true;
+}
+
+//Largest magnitude in a peak file, read from the channel statistics after the arrays
+static bool readPeakLevelFrom(const std::string& path, const PeakFileHeader& expected, float& peak)
+{
+    MappedFile file;
+    if (!file.open(path, MapAccess::Random))
+        return false;
+    ByteSpan bytes = file.bytes();
+    std::vector<LodLevel> shape;
+    std::vector<size_t> counts;
+    if (readPeakTable(bytes, expected, shape, counts) == 0)
+        return false;
+
+    peak = 0.0f;
+    size_t offset = bytes.size - expected.channel_count * sizeof(PeakFileStats);
+    for (unsigned int c = 0; c < expected.channel_count; c++)
+    {
+        PeakFileStats stored = bytes.read<PeakFileStats>(offset + c * sizeof(PeakFileStats));
+        peak = std::max(peak, std::max(-stored.min, stored.max));
+    }
+    return true;
+}
+
+bool loadPeakFile(const std::string& fileName, const WaveReader& reader, std::vector<WaveformLod>& lods,
+                  std::vector<ChannelStats>& stats)
+{
+    lods.clear();
+    stats.clear();
+    PeakFileHeader expected;
+    if (!expectedHeader(fileName, reader, lods, expected))
+        return false;
+
+    std::string cached = cacheFilePath(fileName, ".peaks");
+    if (readPeakFile(fileName + ".peaks", expected, lods, stats) || (!cached.empty() && readPeakFile(cached, expected, lods, stats)))
+    {
+        std::cout << "Loaded peaks of " << fileName << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool readPeakLevel(const std::string& fileName, const WaveReader& reader, float& peak)
+{
+    PeakFileHeader expected;
+    std::vector<WaveformLod> noLevels;
+    if (!expectedHeader(fileName, reader, noLevels, expected))
+        return false;
+    std::string cached = cacheFilePath(fileName, ".peaks");
+    return readPeakLevelFrom(fileName + ".peaks", expected, peak) ||
+           (!cached.empty() && readPeakLevelFrom(cached, expected, peak));
+}
+
+//Write to a temporary file first and move it into place, so a crash never leaves a half written peak file
+static bool writePeakFile(const std::string& path, const PeakFileHeader& header, const std::vector<WaveformLod>& lods,
+                          const std::vector<ChannelStats>& stats)
+{
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        if (!output)
+            return false;
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        const std::vector<LodLevel>& shape = lods[0].getLevels();
+        const size_t firstLevel = firstStoredLevel(lods[0]);
+        for (size_t l = firstLevel; l < shape.size(); l++)
+        {
+            unsigned long long entry[2] = { shape[l].bucket_size, shape[l].min_values.size() };
+            output.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+        }
+        for (const WaveformLod& lod : lods)
+        {
+            for (size_t l = firstLevel; l < lod.getLevels().size(); l++)
+            {
+                const LodLevel& level = lod.getLevels()[l];
+                std::streamsize bytes = static_cast<std::streamsize>(level.min_values.size() * sizeof(float));
+                output.write(reinterpret_cast<const char*>(level.min_values.data()), bytes);
+                output.write(reinterpret_cast<const char*>(level.max_values.data()), bytes);
+                output.write(reinterpret_cast<const char*>(level.rms_values.data()), bytes);
+            }
+        }
+        for (const ChannelStats& channel : stats)
+        {
+            PeakFileStats stored = { channel.min, channel.max, channel.sum, channel.sum_squares, channel.clipped, channel.count };
+            output.write(reinterpret_cast<const char*>(&stored), sizeof(stored));
+        }
+        output.flush();
+        if (!output)
+        {
+            output.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    //rename() does not replace an existing file on Windows
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool savePeakFile(const std::string& fileName, const WaveReader& reader, const std::vector<WaveformLod>& lods,
+                  const std::vector<ChannelStats>& stats)
+{
+    if (lods.empty() || lods[0].getLevels().empty() || stats.size() != lods.size())
+        return false;
+    PeakFileHeader header;
+    if (!expectedHeader(fileName, reader, lods, header))
+        return false;
+
+    if (writePeakFile(fileName + ".peaks", header, lods, stats))
+        return true;
+    std::string cached = cacheFilePath(fileName, ".peaks");
+    if (!cached.empty() && writePeakFile(cached, header, lods, stats))
+        return true;
+
+    std::cout << "WARNING: Could not write a peak file for " << fileName << std::endl;
+    return false;
+}
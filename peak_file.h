@@ -0,0 +1,72 @@
+#pragma once
+
+#include "wave_reader.h"
+#include "waveform_lod.h"
+#include "channel_stats.h"
+#include <string>
+#include <vector>
+
+//Peak files keep the min/max/RMS pyramids of a WAV file on disk so reopening it skips the full pass over its
+//samples. They are written as "<file>.peaks" next to the WAV, or in a per-user cache directory when that folder
+//is not writable. A peak file only matches while the size, modification time and header bytes of its WAV are
+//unchanged.
+//
+//Layout, little-endian, every array 4-byte aligned so the file can be used straight from a mapping:
+//  PeakFileHeader (64 bytes)
+//  level_count x { bucket_size (u64), bucket_count (u64) }, finest level first
+//  for each channel, for each level: min[bucket_count], max[bucket_count], rms[bucket_count] (float)
+//  for each channel: PeakFileStats (40 bytes), version 2 on
+//
+//Bumped whenever the layout changes, files of any other version are ignored and rewritten
+const unsigned int peakFileVersion = 2;
+
+//Finest level a peak file keeps. Files decoded into memory build buckets of 16 samples, stored whole their peak
+//file would be a fifth the size of the samples. The coarser levels are enough to draw the overview while the
+//decode pass rebuilds the rest.
+const size_t peakFileMinBucketSize = 1024;
+
+struct PeakFileHeader {
+    char magic[8];                      //"WVPEAKS" and a terminating 0
+    unsigned int version;
+    unsigned int channel_count;
+    unsigned long long source_size;
+    long long source_mtime;
+    unsigned long long header_hash;     //FNV-1a of WaveReader::headerBytes()
+    unsigned long long sample_count;
+    unsigned int level_count;
+    unsigned int reserved[3];
+};
+
+//ChannelStats as stored on disk
+struct PeakFileStats {
+    float min;
+    float max;
+    double sum;
+    double sum_squares;
+    unsigned long long clipped;
+    unsigned long long count;
+};
+
+//Fill "lods" and "stats" (one per channel) from a peak file matching "fileName". Returns false if there is none
+//or it is stale, both are then left empty.
+bool loadPeakFile(const std::string& fileName, const WaveReader& reader, std::vector<WaveformLod>& lods,
+                  std::vector<ChannelStats>& stats);
+
+//Largest sample magnitude of "fileName" across all channels, from the channel statistics in its peak file.
+//Returns false if there is no current peak file.
+bool readPeakLevel(const std::string& fileName, const WaveReader& reader, float& peak);
+
+//Write the pyramids and channel statistics of "fileName" to its peak file, from the first level with buckets of
+//at least peakFileMinBucketSize on. Returns false if neither location could be written.
+bool savePeakFile(const std::string& fileName, const WaveReader& reader, const std::vector<WaveformLod>& lods,
+                  const std::vector<ChannelStats>& stats);
+
+//Per-user directory for peak files of WAVs in read-only folders, empty if there is none
+std::string peakCacheDirectory();
+
+//File in peakCacheDirectory() for "fileName", named after a hash of its absolute path plus "extension". Empty if
+//there is no cache directory.
+std::string cacheFilePath(const std::string& fileName, const char* extension);
+
+//Size and modification time of "fileName", false if it cannot be read
+bool fileStamp(const std::string& fileName, unsigned long long& size, long long& mtime);
@@ -0,0 +1,201 @@
+#include "probe.h"
+#include "wave_reader.h"
+#include "thread_pool.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+int probeFile(const std::string& fileName, Wave& wave)
+{
+    //Random access: only the header pages are touched, don't let the OS read ahead into the samples
+    WaveReader reader;
+    if (reader.open(fileName, MapAccess::Random) != 0)
+        return -1;
+    wave = reader.getWave();
+    return 0;
+}
+
+std::vector<ProbeResult> probeFiles(const std::vector<std::string>& fileNames)
+{
+    std::vector<ProbeResult> results(fileNames.size());
+    ThreadPool::shared().parallelFor(fileNames.size(), 16, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            results[i].file_name = fileNames[i];
+            results[i].status = probeFile(fileNames[i], results[i].wave);
+        }
+    });
+    return results;
+}
+
+//One output column: its name, the formatted value and whether JSON needs it quoted
+struct ProbeField {
+    const char* name;
+    std::string value;
+    bool is_text;
+};
+
+static std::string number(long long value)
+{
+    return std::to_string(value);
+}
+
+static std::vector<ProbeField> probeFields(const ProbeResult& result)
+{
+    const Wave& wave = result.wave;
+    char duration[32];
+    snprintf(duration, sizeof(duration), "%.6f", wave.duration);
+    return {
+        { "file", result.file_name, true },
+        { "ok", result.status == 0 ? "true" : "false", false },
+        { "container", wave.chunk_id, true },
+        { "audio_format", number(static_cast<unsigned short>(wave.audio_format)), false },
+        { "sub_format", number(static_cast<unsigned short>(wave.sub_format)), false },
+        { "num_channels", number(wave.num_channels), false },
+        { "sample_rate", number(wave.sample_rate), false },
+        { "byte_rate", number(wave.byte_rate), false },
+        { "block_align", number(wave.block_align), false },
+        { "bits_per_sample", number(wave.bits_per_sample), false },
+        { "valid_bits_per_sample", number(wave.valid_bits_per_sample), false },
+        { "channel_mask", number(wave.channel_mask), false },
+        { "data_size", std::to_string(wave.subchunk2_size), false },
+        { "number_of_samples", std::to_string(wave.number_of_samples), false },
+        { "duration", duration, false },
+    };
+}
+
+static std::string escapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += static_cast<char>(c);
+        }
+        else if (c < 0x20)
+        {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        }
+        else
+        {
+            escaped += static_cast<char>(c);
+        }
+    }
+    return escaped;
+}
+
+static std::string escapeCsv(const std::string& text)
+{
+    if (text.find_first_of(",\"\r\n") == std::string::npos)
+        return text;
+    std::string escaped = "\"";
+    for (char c : text)
+    {
+        if (c == '"')
+            escaped += '"';
+        escaped += c;
+    }
+    return escaped + "\"";
+}
+
+void writeProbeJson(std::ostream& out, const std::vector<ProbeResult>& results)
+{
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        std::vector<ProbeField> fields = probeFields(results[i]);
+        out << "  {";
+        for (size_t f = 0; f < fields.size(); f++)
+        {
+            out << (f == 0 ? "" : ", ") << '"' << fields[f].name << "\": ";
+            if (fields[f].is_text)
+                out << '"' << escapeJson(fields[f].value) << '"';
+            else
+                out << fields[f].value;
+        }
+        out << (i + 1 < results.size() ? "},\n" : "}\n");
+    }
+    out << "]\n";
+}
+
+void writeProbeCsv(std::ostream& out, const std::vector<ProbeResult>& results)
+{
+    std::vector<ProbeField> header = probeFields(ProbeResult());
+    for (size_t f = 0; f < header.size(); f++)
+        out << (f == 0 ? "" : ",") << header[f].name;
+    out << "\n";
+
+    for (const ProbeResult& result : results)
+    {
+        std::vector<ProbeField> fields = probeFields(result);
+        for (size_t f = 0; f < fields.size(); f++)
+            out << (f == 0 ? "" : ",") << escapeCsv(fields[f].value);
+        out << "\n";
+    }
+}
+
+int runProbeCommand(int argc, char** argv)
+{
+#ifdef _WIN32
+    //Release builds use the Windows subsystem and start without a console. Write to the one the command was
+    //typed in, unless the output is already redirected to a file or pipe.
+    if (GetFileType(GetStdHandle(STD_OUTPUT_HANDLE)) == FILE_TYPE_UNKNOWN && AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        freopen("CONOUT$", "w", stdout);
+        freopen("CONOUT$", "w", stderr);
+    }
+#endif
+
+    bool csv = false;
+    std::vector<std::string> fileNames;
+    for (int i = 2; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else if (std::strcmp(argv[i], "--json") == 0)
+            csv = false;
+        else
+            fileNames.push_back(argv[i]);
+    }
+
+    //Long lists do not fit on a command line, take them from stdin instead
+    if (fileNames.empty())
+    {
+        std::string line;
+        while (std::getline(std::cin, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty())
+                fileNames.push_back(line);
+        }
+    }
+
+    //The parser reports problems on std::cout, send those to stderr so stdout stays machine readable
+    std::streambuf* output = std::cout.rdbuf(std::cerr.rdbuf());
+    std::vector<ProbeResult> results = probeFiles(fileNames);
+    std::cout.rdbuf(output);
+
+    if (csv)
+        writeProbeCsv(std::cout, results);
+    else
+        writeProbeJson(std::cout, results);
+
+    for (const ProbeResult& result : results)
+    {
+        if (result.status != 0)
+            return 1;
+    }
+    return 0;
+}
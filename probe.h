@@ -0,0 +1,30 @@
+#pragma once
+
+#include "wave.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+//Header-only metadata scan. Only the RIFF, fmt and chunk headers are read, never the samples, so probing costs
+//a few pages of I/O per file whatever its length.
+
+struct ProbeResult {
+    std::string file_name;
+    int status = -1;            //0 when the header could be parsed
+    Wave wave;
+};
+
+//Parse the header of "fileName" into "wave". Returns 0 on success and -1 if it is not a WAV file that can be
+//decoded.
+int probeFile(const std::string& fileName, Wave& wave);
+
+//Probe every file in parallel on the shared thread pool. Results keep the order of "fileNames".
+std::vector<ProbeResult> probeFiles(const std::vector<std::string>& fileNames);
+
+//One JSON array with an object per file, or CSV with a header row
+void writeProbeJson(std::ostream& out, const std::vector<ProbeResult>& results);
+void writeProbeCsv(std::ostream& out, const std::vector<ProbeResult>& results);
+
+//"probe [--json|--csv] [files...]". Paths are read from stdin, one per line, when none are given. Returns the
+//process exit code: 0 if every file could be probed, 1 otherwise.
+int runProbeCommand(int argc, char** argv);
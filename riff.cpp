@@ -0,0 +1,114 @@
+#include "riff.h"
+
+#include <cstring>
+#include <utility>
+
+//Chunk ids are four printable ASCII characters. Used to tell whether a writer forgot the pad byte after an odd
+//sized chunk.
+static bool looksLikeChunkId(const ByteSpan& file, size_t offset)
+{
+    if (offset + 4 > file.size)
+        return false;
+    for (size_t i = 0; i < 4; i++)
+    {
+        unsigned char c = file.data[offset + i];
+        if (c < 0x20 || c > 0x7E)
+            return false;
+    }
+    return true;
+}
+
+//64-bit sizes from an RF64/BW64 ds64 chunk
+struct Ds64Sizes {
+    bool present = false;
+    unsigned long long data_size = 0;
+    std::vector<std::pair<std::string, unsigned long long>> table;     //Sizes of other oversized chunks
+};
+
+static void readDs64(const ByteSpan& file, const RiffChunk& chunk, RiffHeader& header, Ds64Sizes& sizes)
+{
+    //riffSize (8), dataSize (8), sampleCount (8), tableLength (4), then tableLength * (id (4), size (8))
+    size_t pos = static_cast<size_t>(chunk.payloadOffset());
+    if (chunk.size < 28 || pos + 28 > file.size)
+        return;
+    sizes.present = true;
+    sizes.data_size = file.read<unsigned long long>(pos + 8);
+    header.sample_count = file.read<unsigned long long>(pos + 16);
+
+    unsigned int tableLength = file.read<unsigned int>(pos + 24);
+    size_t entry = pos + 28;
+    for (unsigned int i = 0; i < tableLength && entry + 12 <= file.size && entry + 12 <= pos + chunk.size; i++, entry += 12)
+    {
+        std::string id(reinterpret_cast<const char*>(file.data + entry), 4);
+        sizes.table.emplace_back(id, file.read<unsigned long long>(entry + 4));
+    }
+}
+
+bool parseRiffChunks(const ByteSpan& file, RiffHeader& header, std::vector<RiffChunk>& chunks)
+{
+    chunks.clear();
+    header = RiffHeader();
+
+    if (file.size < 12)
+        return false;
+    header.container.assign(reinterpret_cast<const char*>(file.data), 4);
+    if (header.container != "RIFF" && header.container != "RF64" && header.container != "BW64")
+        return false;
+    header.form.assign(reinterpret_cast<const char*>(file.data + 8), 4);
+
+    Ds64Sizes sizes;
+    unsigned long long offset = 12;
+    while (offset + 8 <= file.size)
+    {
+        //Anything that is not a chunk header means the walk went off the rails (or into samples that follow an
+        //unpatched size field), stop here
+        if (!looksLikeChunkId(file, static_cast<size_t>(offset)))
+            break;
+
+        RiffChunk chunk;
+        chunk.id.assign(reinterpret_cast<const char*>(file.data + offset), 4);
+        chunk.offset = offset;
+        chunk.size = file.read<unsigned int>(static_cast<size_t>(offset) + 4);
+
+        //ds64 must come first in an RF64 file, its sizes override the 0xFFFFFFFF placeholders that follow
+        if (header.is64Bit() && chunk.id == "ds64")
+            readDs64(file, chunk, header, sizes);
+        else if (sizes.present && chunk.size == 0xFFFFFFFFull)
+        {
+            if (chunk.id == "data")
+                chunk.size = sizes.data_size;
+            for (const auto& entry : sizes.table)
+            {
+                if (entry.first == chunk.id)
+                    chunk.size = entry.second;
+            }
+        }
+        chunks.push_back(chunk);
+
+        //A chunk that claims to run past the end of the file is the last one we can see
+        unsigned long long remaining = file.size - chunk.payloadOffset();
+        if (chunk.size >= remaining)
+            break;
+
+        //Chunks are padded to an even size, but some writers skip the pad byte. A written pad byte is zero, which
+        //no id starts with, so only step over it when the unpadded offset does not hold an id.
+        unsigned long long next = chunk.payloadOffset() + chunk.size;
+        if ((chunk.size & 1) && !looksLikeChunkId(file, static_cast<size_t>(next)))
+            next += 1;
+        offset = next;
+    }
+    return true;
+}
+
+const RiffChunk* findChunk(const std::vector<RiffChunk>& chunks, const char* id, bool skipEmpty)
+{
+    for (const RiffChunk& chunk : chunks)
+    {
+        if (chunk.id.compare(0, 4, id, 4) != 0)
+            continue;
+        if (skipEmpty && chunk.size == 0)
+            continue;
+        return &chunk;
+    }
+    return nullptr;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "mapped_file.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+//One top-level chunk of a RIFF file. Offsets and sizes are 64-bit so RF64/BW64 files above 4 GB fit.
+struct RiffChunk {
+    std::string id;                     //Four character code, e.g. "fmt " or "data"
+    unsigned long long offset = 0;      //Offset of the chunk header (the id) from the start of the file
+    unsigned long long size = 0;        //Payload size, taken from the ds64 chunk for RF64 files
+
+    unsigned long long payloadOffset() const { return offset + 8; }
+};
+
+//The outer header of the file
+struct RiffHeader {
+    std::string container;              //"RIFF", or "RF64"/"BW64" for files with 64-bit sizes
+    std::string form;                   //Form type, e.g. "WAVE"
+    unsigned long long sample_count = 0;    //Frame count from the ds64 chunk, 0 when absent
+
+    bool is64Bit() const { return container != "RIFF"; }
+};
+
+//Walk the chunks of a RIFF file by hopping from header to header using each chunk's size field. Nothing inside a
+//chunk payload is ever scanned. For RF64/BW64 files the 32-bit size fields set to 0xFFFFFFFF are replaced by the
+//64-bit sizes in the ds64 chunk.
+//Returns false if the file does not start with a RIFF, RF64 or BW64 header.
+bool parseRiffChunks(const ByteSpan& file, RiffHeader& header, std::vector<RiffChunk>& chunks);
+
+//First chunk with the given id, or nullptr. With skipEmpty set, chunks with a declared size of 0 are ignored.
+const RiffChunk* findChunk(const std::vector<RiffChunk>& chunks, const char* id, bool skipEmpty = false);
@@ -0,0 +1,119 @@
+#include "sample_store.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+static void* alignedAllocate(size_t bytes, size_t alignment)
+{
+#ifdef _WIN32
+    return _aligned_malloc(bytes, alignment);
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignment, bytes) != 0)
+        return nullptr;
+    return memory;
+#endif
+}
+
+static void alignedFree(void* memory)
+{
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+SampleStore::~SampleStore()
+{
+    clear();
+}
+
+bool SampleStore::allocate(int channels, size_t frames, PcmFormat format)
+{
+    clear();
+    if (channels <= 0 || frames == 0)
+        return true;
+
+    //Round each channel up to a whole number of cache lines so every channel starts aligned. A multiple of
+    //"alignment" frames does that for any sample width, including 3 byte samples.
+    const size_t width = pcmBytesPerSample(format);
+    size_t paddedFrames = (frames + alignment - 1) / alignment * alignment;
+    if (paddedFrames > static_cast<size_t>(-1) / width / channels)
+        return false;
+
+    unsigned char* memory = static_cast<unsigned char*>(alignedAllocate(paddedFrames * width * channels, alignment));
+    if (memory == nullptr)
+        return false;
+
+    buffer = memory;
+    stride = paddedFrames * width;
+    frame_count = frames;
+    channel_count = channels;
+    sample_format = format;
+    return true;
+}
+
+bool SampleStore::resize(size_t frames)
+{
+    if (frames <= capacity())
+    {
+        frame_count = frames;
+        return true;
+    }
+
+    //Double the room so a file that keeps growing is not copied for every few frames appended
+    const size_t width = pcmBytesPerSample(sample_format);
+    size_t wanted = std::max(frames, capacity() * 2);
+    size_t paddedFrames = (wanted + alignment - 1) / alignment * alignment;
+    if (channel_count <= 0 || paddedFrames > static_cast<size_t>(-1) / width / channel_count)
+        return false;
+    unsigned char* memory = static_cast<unsigned char*>(alignedAllocate(paddedFrames * width * channel_count, alignment));
+    if (memory == nullptr)
+        return false;
+
+    for (int c = 0; c < channel_count; c++)
+        std::memcpy(memory + paddedFrames * width * c, channelBytes(c), frame_count * width);
+    alignedFree(buffer);
+    buffer = memory;
+    stride = paddedFrames * width;
+    frame_count = frames;
+    return true;
+}
+
+void SampleStore::clear()
+{
+    if (buffer != nullptr)
+        alignedFree(buffer);
+    buffer = nullptr;
+    stride = 0;
+    frame_count = 0;
+    channel_count = 0;
+    sample_format = PcmFormat::Float32;
+}
+
+ChannelSpan SampleStore::span(int c) const
+{
+    ChannelSpan result;
+    if (c < 0 || c >= channel_count || sample_format != PcmFormat::Float32)
+        return result;
+    result.data = channel(c);
+    result.size = frame_count;
+    return result;
+}
+
+void SampleStore::toFloat(int c, size_t first, size_t count, float* out) const
+{
+    if (c < 0 || c >= channel_count || first >= frame_count)
+        return;
+    if (count > frame_count - first)
+        count = frame_count - first;
+
+    //A planar run is a mono stream, so the mono decode kernels do the conversion
+    const unsigned char* src = channelBytes(c) + first * pcmBytesPerSample(sample_format);
+    decodeInterleaved(sample_format, src, count, 1, &out);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "pcm_decode.h"
+#include <cstddef>
+
+//Read-only view of one channel inside a SampleStore holding floats
+struct ChannelSpan {
+    const float* data = nullptr;
+    size_t size = 0;
+
+    const float* begin() const { return data; }
+    const float* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+    float operator[](size_t i) const { return data[i]; }
+};
+
+//Planar sample storage for any number of channels. All channels live in one contiguous, cache-line aligned
+//allocation, back to back, with every channel starting on its own cache line. Samples are either floats or, in
+//compact mode, kept at the width of the file (int16, packed int24, int32 or float32) and converted where they are
+//read, which halves the memory of 16-bit files.
+class SampleStore {
+public:
+    static const size_t alignment = 64;
+
+    SampleStore() = default;
+    ~SampleStore();
+
+    SampleStore(const SampleStore&) = delete;
+    SampleStore& operator=(const SampleStore&) = delete;
+
+    //Drop the current contents and make room for "frames" samples in each of "channels" channels, stored as
+    //"format". The samples are left uninitialized. Returns false if the memory cannot be allocated.
+    bool allocate(int channels, size_t frames, PcmFormat format = PcmFormat::Float32);
+    void clear();
+
+    //Change the number of frames, keeping the samples of every channel that are already there. New frames are
+    //left uninitialized. Grows the capacity geometrically, so appending a little at a time costs amortized O(1)
+    //per frame. Returns false, leaving the store as it was, if the memory cannot be allocated.
+    bool resize(size_t frames);
+
+    int channelCount() const { return channel_count; }
+    size_t frameCount() const { return frame_count; }
+    PcmFormat format() const { return sample_format; }
+    size_t bytes() const { return stride * channel_count; }
+    //Frames each channel has room for before resize() has to move the samples
+    size_t capacity() const { return stride / pcmBytesPerSample(sample_format); }
+
+    //Float samples of channel c. Only valid when format() is Float32, nullptr otherwise.
+    float* channel(int c) { return sample_format == PcmFormat::Float32 ? reinterpret_cast<float*>(channelBytes(c)) : nullptr; }
+    const float* channel(int c) const { return sample_format == PcmFormat::Float32 ? reinterpret_cast<const float*>(channelBytes(c)) : nullptr; }
+    ChannelSpan span(int c) const;
+
+    //Raw samples of channel c at the width of format()
+    unsigned char* channelBytes(int c) { return buffer + stride * c; }
+    const unsigned char* channelBytes(int c) const { return buffer + stride * c; }
+
+    //Convert samples [first, first + count) of channel c to float, whatever the storage format
+    void toFloat(int c, size_t first, size_t count, float* out) const;
+
+private:
+    unsigned char* buffer = nullptr;
+    size_t stride = 0;          //Bytes from the start of one channel to the start of the next
+    size_t frame_count = 0;
+    int channel_count = 0;
+    PcmFormat sample_format = PcmFormat::Float32;
+};
@@ -0,0 +1,109 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threadCount; i++)
+        workers.emplace_back([this]() { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t minGrain, const std::function<void(size_t, size_t)>& fn)
+{
+    if (count == 0)
+        return;
+
+    //Aim for a few ranges per thread so uneven ranges still balance out
+    size_t threads = workers.size() + 1;
+    size_t grain = std::max<size_t>(std::max<size_t>(minGrain, 1), (count + threads * 4 - 1) / (threads * 4));
+    size_t rangeCount = (count + grain - 1) / grain;
+    if (rangeCount == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    //Shared with the helper tasks, which may still be queued after this call has returned
+    struct Job {
+        std::atomic<size_t> next_range{ 0 };
+        std::atomic<size_t> done_ranges{ 0 };
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    const std::function<void(size_t, size_t)>* body = &fn;
+
+    //Take ranges until none are left. Helpers that start after the last range was taken return immediately and
+    //never touch "body".
+    auto drain = [job, body, count, grain, rangeCount]()
+    {
+        for (;;)
+        {
+            size_t range = job->next_range.fetch_add(1);
+            if (range >= rangeCount)
+                return;
+            size_t begin = range * grain;
+            (*body)(begin, std::min(begin + grain, count));
+            if (job->done_ranges.fetch_add(1) + 1 == rangeCount)
+            {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                job->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(workers.size(), rangeCount - 1);
+    for (size_t i = 0; i < helpers; i++)
+        submit(drain);
+    drain();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&job, rangeCount]() { return job->done_ranges.load() == rangeCount; });
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads fed from one task queue
+class ThreadPool {
+public:
+    //threadCount == 0 uses one thread per hardware thread
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    //Queue a task, it runs on whichever worker becomes free first
+    void submit(std::function<void()> task);
+
+    //Split [0, count) into ranges of at least minGrain items and call fn(begin, end) for each, on the workers and
+    //on the calling thread. Returns once every range is done. Safe to call from inside a pool task because the
+    //caller keeps taking ranges itself instead of only waiting.
+    void parallelFor(size_t count, size_t minGrain, const std::function<void(size_t, size_t)>& fn);
+
+    //Process-wide pool shared by the loaders
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
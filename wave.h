@@ -3,6 +3,8 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include "riff.h"
+#include "channel_stats.h"
 
 //Source for this information from http://soundfile.sapp.org/doc/WaveFormat/
 
@@ -25,6 +27,9 @@ struct Wave {
 		byte_rate = 0;
 		block_align = 0;
 		bits_per_sample = 0;
+		valid_bits_per_sample = 0;
+		channel_mask = 0;
+		sub_format = 0;
 
 		//Data sub-chunk
 		subchunk2_id = "";
@@ -54,6 +59,9 @@ struct Wave {
 		byte_rate = 0;
 		block_align = 0;
 		bits_per_sample = 0;
+		valid_bits_per_sample = 0;
+		channel_mask = 0;
+		sub_format = 0;
 
 		//Data sub-chunk
 		subchunk2_id = "";
@@ -65,6 +73,8 @@ struct Wave {
 		//Extra
 		number_of_samples = 0;
 		sample_size = 0;
+		chunks.clear();
+		channel_stats.clear();
 	}
 
 	//Riff Chunk
@@ -82,13 +92,25 @@ struct Wave {
 	short block_align;
 	short bits_per_sample;
 
+	//WAVE_FORMAT_EXTENSIBLE only, 0 otherwise. sub_format is the format tag taken from the SubFormat GUID.
+	short valid_bits_per_sample;
+	int channel_mask;
+	short sub_format;
+
 	//Data sub-chunk
 	std::string subchunk2_id; 
-	int subchunk2_size;
+	unsigned long long subchunk2_size;
 	float duration; 
-	int max_amplitude;
+	float max_amplitude;
 	double frequency;
-	int number_of_samples;
+	unsigned long long number_of_samples;
 	int sample_size;
+
+	//Index of every top-level RIFF chunk (id, offset, size) found while loading
+	std::vector<RiffChunk> chunks;
+
+	//Peak, RMS, DC offset and clip count of each channel, filled by the decode pass. max_amplitude is the
+	//largest peak of any channel.
+	std::vector<ChannelStats> channel_stats;
 };
 
@@ -0,0 +1,462 @@
+#include "wave_loader.h"
+#include "wave_reader.h"
+#include "peak_file.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <iostream>
+
+//Peak bytes held by one vector grown to "count" elements through push_back. During each reallocation the old and
+//the new block are alive at the same time. Uses MSVC's 1.5x growth policy, which is what this project ships with.
+static size_t pushBackPeakBytes(size_t count, size_t elementSize)
+{
+    size_t capacity = 0;
+    size_t peak = 0;
+    while (capacity < count)
+    {
+        size_t grown = capacity + capacity / 2;
+        size_t next = (grown > capacity) ? grown : capacity + 1;
+        peak = std::max(peak, (capacity + next) * elementSize);
+        capacity = next;
+    }
+    return std::max(peak, capacity * elementSize);
+}
+
+//Largest float expansion of a file that is decoded into memory, anything bigger is loaded as an overview only
+static const unsigned long long decodedBudgetBytes = 2ull << 30;
+
+//Finest pyramid bucket for overview-only files. Close-ups of those come from the page cache, so their pyramid
+//(and peak file) can stay small.
+static const size_t overviewBucketSize = 1024;
+
+//What the sample store holds for "reader". Compact stores keep the width of the file, except for sources wider
+//than float which would only grow.
+static PcmFormat storageFormat(const WaveReader& reader, bool compact)
+{
+    if (!compact || pcmBytesPerSample(reader.getFormat()) > sizeof(float))
+        return PcmFormat::Float32;
+    return reader.getFormat();
+}
+
+//A data version no other load or append has used
+static unsigned long long nextDataVersion()
+{
+    static std::atomic<unsigned long long> counter{ 0 };
+    return ++counter;
+}
+
+//Wave::max_amplitude from the per-channel statistics
+static void setMaxAmplitude(Wave& wave)
+{
+    float peak = 0.0f;
+    for (const ChannelStats& stats : wave.channel_stats)
+        peak = std::max(peak, stats.peak());
+    wave.max_amplitude = peak;
+}
+
+//Read the file by bytes to extract data from the .wav file
+int readFile(const std::string& fileName, LoadedAudio& audio, LoadProgress* progress, const LoadOptions& options)
+{
+    if (openFile(fileName, audio, options) != 0)
+        return -1;
+    if (buildOverview(audio, progress) != 0)
+        return -1;
+    adoptDecodedPyramids(audio);
+    return 0;
+}
+
+int openFile(const std::string& fileName, LoadedAudio& audio, const LoadOptions& options)
+{
+    //Parse the header, the samples are pulled from the reader later
+    audio.reader.reset(new WaveReader());
+    if (audio.reader->open(fileName) != 0)
+    {
+        audio.reader.reset();
+        return -1;
+    }
+    audio.file_name = fileName;
+    audio.wave = audio.reader->getWave();
+    audio.data_version = nextDataVersion();
+
+    //Compact storage keeps the samples at the width of the file
+    const WaveReader& reader = *audio.reader;
+    audio.compact_samples = options.compact_samples;
+    size_t storedWidth = pcmBytesPerSample(storageFormat(reader, audio.compact_samples));
+
+    //Files whose samples would not fit the budget (e.g. multi-hour RF64 recordings) are never fully
+    //materialized. Only their overview is built, by streaming the mapping through small per-thread buffers, and
+    //close-ups are decoded on demand through the page cache.
+    audio.overview_only = static_cast<unsigned long long>(reader.frameCount()) * reader.channelCount() * storedWidth > decodedBudgetBytes;
+    if (audio.overview_only)
+        audio.pages.reset(new PageCache(reader, options.page_cache_budget));
+
+    //A current peak file gives the overview right away. Files that fit in memory are still decoded in full, they
+    //are drawn from it meanwhile.
+    if (loadPeakFile(fileName, reader, audio.lods, audio.wave.channel_stats))
+    {
+        setMaxAmplitude(audio.wave);
+        audio.overview_ready = true;
+    }
+    return 0;
+}
+
+int buildOverview(LoadedAudio& audio, LoadProgress* progress)
+{
+    if (!audio.reader)
+        return -1;
+    if (audio.overview_ready && audio.overview_only)
+        return 0;
+    const WaveReader& reader = *audio.reader;
+    const Wave& wave = audio.wave;
+    const size_t frameCount = reader.frameCount();
+    const int channelCount = reader.channelCount();
+
+    //The sample store is sized exactly once from the (bounded) frame count, nothing grows while decoding
+    const PcmFormat storedFormat = storageFormat(reader, audio.compact_samples);
+    if (!audio.overview_only && !audio.samples.allocate(channelCount, frameCount, storedFormat))
+    {
+        std::cout << "ERROR: Not enough memory to hold " << frameCount << " frames." << std::endl;
+        return -1;
+    }
+    if (!audio.overview_only)
+    {
+        const size_t sampleBytes = pcmBytesPerSample(storedFormat);
+        audio.preallocation_saved_bytes = channelCount * (pushBackPeakBytes(frameCount, sampleBytes) - frameCount * sampleBytes);
+    }
+    if (progress != nullptr)
+        progress->bytes_total = static_cast<unsigned long long>(frameCount) * wave.block_align;
+
+    //An overview read from the peak file may be drawn while this runs, the pyramids are then built on the side
+    const bool fromPeakFile = audio.overview_ready;
+    std::vector<WaveformLod>& lods = fromPeakFile ? audio.decoded_lods : audio.lods;
+    lods.resize(channelCount);
+    for (WaveformLod& lod : lods)
+        lod.reset(frameCount, audio.overview_only ? overviewBucketSize : WaveformLod::baseBucketSize);
+
+    //Pull the interleaved frames from the mapping into the planar channels. Frames are independent,
+    //so slices of frames are decoded in parallel on the shared pool. Each slice is summarized into level 0 of
+    //the pyramids while it is still in cache, and progress and cancellation are checked between slices.
+    //Compact stores are filled without conversion, the pyramid then converts each channel of the slice back
+    //out of the store.
+    const size_t sliceFrames = 1 << 16;
+    const size_t sliceCount = (frameCount + sliceFrames - 1) / sliceFrames;
+    const bool floatStore = !audio.overview_only && storedFormat == PcmFormat::Float32;
+    const size_t storedWidth = pcmBytesPerSample(storedFormat);
+
+    //Channel statistics come out of the same pass. Every slice keeps its own and they are merged in slice order
+    //afterwards, so the sums do not depend on which thread ran which slice.
+    const ClipRange clip = clipRange(reader.getFormat());
+    std::vector<ChannelStats> sliceStats(sliceCount * channelCount);
+    ThreadPool::shared().parallelFor(sliceCount, 1, [&](size_t begin, size_t end)
+    {
+        std::vector<float*> channels(channelCount);
+        std::vector<unsigned char*> rawChannels(channelCount);
+        std::vector<float> scratch(floatStore ? 0 : sliceFrames * channelCount);
+        for (size_t slice = begin; slice < end; slice++)
+        {
+            if (progress != nullptr && progress->cancel)
+                return;
+
+            size_t first = slice * sliceFrames;
+            size_t count = std::min(sliceFrames, frameCount - first);
+            for (int c = 0; c < channelCount; c++)
+                channels[c] = floatStore ? audio.samples.channel(c) + first : scratch.data() + sliceFrames * c;
+            if (audio.overview_only || floatStore)
+            {
+                reader.readFramesAt(first, channels.data(), count);
+            }
+            else
+            {
+                for (int c = 0; c < channelCount; c++)
+                    rawChannels[c] = audio.samples.channelBytes(c) + first * storedWidth;
+                reader.splitFramesAt(first, rawChannels.data(), count);
+                for (int c = 0; c < channelCount; c++)
+                    audio.samples.toFloat(c, first, count, channels[c]);
+            }
+
+            for (int c = 0; c < channelCount; c++)
+            {
+                lods[c].summarize(first, channels[c], count);
+                accumulateStats(channels[c], count, clip, sliceStats[slice * channelCount + c]);
+            }
+
+            if (progress != nullptr)
+                progress->bytes_decoded += static_cast<unsigned long long>(count) * wave.block_align;
+        }
+    });
+
+    if (progress != nullptr && progress->cancel)
+    {
+        std::cout << "Loading cancelled." << std::endl;
+        return -1;
+    }
+
+    //Build the coarser pyramid levels, one channel per task
+    ThreadPool::shared().parallelFor(channelCount, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t c = begin; c < end; c++)
+            lods[c].finish();
+    });
+    if (!fromPeakFile)
+    {
+        audio.wave.channel_stats.assign(channelCount, ChannelStats());
+        for (size_t slice = 0; slice < sliceCount; slice++)
+        {
+            for (int c = 0; c < channelCount; c++)
+                audio.wave.channel_stats[c].merge(sliceStats[slice * channelCount + c]);
+        }
+        setMaxAmplitude(audio.wave);
+        audio.overview_ready.store(true, std::memory_order_release);
+
+        //Keep the pyramids on disk, the next open can draw them before decoding anything
+        savePeakFile(audio.file_name, reader, audio.lods, audio.wave.channel_stats);
+    }
+
+    //Everything is in memory now, the file does not need to stay mapped
+    if (!audio.overview_only)
+    {
+        audio.samples_ready.store(true, std::memory_order_release);
+        audio.reader.reset();
+    }
+
+    std::cout << "Loaded Succesfully" << std::endl;
+    return 0;
+}
+
+void adoptDecodedPyramids(LoadedAudio& audio)
+{
+    if (audio.decoded_lods.empty())
+        return;
+    audio.lods.swap(audio.decoded_lods);
+    audio.decoded_lods.clear();
+    audio.data_version = nextDataVersion();
+}
+
+size_t queryColumns(LoadedAudio& audio, int channel, size_t start, size_t end, size_t columns,
+                    std::vector<float>& out_min, std::vector<float>& out_max)
+{
+    bool ready = audio.overview_ready.load(std::memory_order_acquire);
+    if (!audio.overview_only && !ready)
+        return 0;
+    bool decoded = !audio.overview_only && audio.samples_ready.load(std::memory_order_acquire);
+
+    //Float samples in memory: the pyramid reads them itself when zoomed in
+    const float* samples = decoded ? audio.samples.channel(channel) : nullptr;
+    if (samples != nullptr)
+        return audio.lods[channel].query(samples, start, end, columns, out_min, out_max);
+
+    //Otherwise the pyramid while its level 0 is fine enough, and at every zoom while the samples are decoding
+    bool decoding = !audio.overview_only && !decoded;
+    if (ready && (decoding || end - start >= columns * audio.lods[channel].finestBucketSize()))
+        return audio.lods[channel].query(nullptr, start, end, columns, out_min, out_max);
+
+    //Closer than that compact stores convert just the visible samples. That is fewer than columns times the
+    //finest bucket size, a few tens of thousands at most.
+    if (!audio.overview_only)
+    {
+        static std::vector<float> visible;
+        end = std::min(end, audio.samples.frameCount());
+        if (start >= end)
+            return 0;
+        visible.resize(end - start);
+        audio.samples.toFloat(channel, start, end - start, visible.data());
+        return WaveformLod::reduce(visible.data(), visible.size(), columns, out_min, out_max);
+    }
+
+    //Overview-only files decode pages, also while the pyramid is still being built
+    if (!audio.pages)
+        return 0;
+    return audio.pages->query(channel, start, end, columns, out_min, out_max);
+}
+
+AsyncLoader::~AsyncLoader()
+{
+    cancel();
+    if (worker.joinable())
+        worker.join();
+}
+
+void AsyncLoader::start(const std::string& fileName, const LoadOptions& options)
+{
+    //Only one load at a time, a previous (possibly cancelled) worker must be gone first
+    if (worker.joinable())
+        worker.join();
+
+    file_name = fileName;
+    state.bytes_decoded = 0;
+    state.bytes_total = 0;
+    state.cancel = false;
+    result.reset();
+    result_status = -1;
+    opened = nullptr;
+    finished = false;
+    loading = true;
+
+    worker = std::thread([this, fileName, options]()
+    {
+        std::unique_ptr<LoadedAudio> audio(new LoadedAudio());
+        int status = openFile(fileName, *audio, options);
+        if (status == 0)
+        {
+            //Overview-only files can already be drawn from their page cache, others from their peak file
+            if (audio->overview_only || audio->overview_ready)
+                opened.store(audio.get(), std::memory_order_release);
+            status = buildOverview(*audio, &state);
+        }
+
+        //The audio is freed on the render thread in poll(), it may still be drawing the preview
+        result = std::move(audio);
+        result_status = status;
+
+        //Publish the result, everything written above is visible to the thread that observes finished == true
+        finished.store(true, std::memory_order_release);
+    });
+}
+
+void AsyncLoader::cancel()
+{
+    state.cancel = true;
+}
+
+float AsyncLoader::progress() const
+{
+    unsigned long long total = state.bytes_total;
+    if (total == 0)
+        return 0.0f;
+    return static_cast<float>(static_cast<double>(state.bytes_decoded) / static_cast<double>(total));
+}
+
+bool AsyncLoader::poll(std::unique_ptr<LoadedAudio>& audio, int& status)
+{
+    if (!loading || !finished.load(std::memory_order_acquire))
+        return false;
+
+    worker.join();
+    loading = false;
+    status = state.cancel ? -1 : result_status;
+    if (status == 0)
+    {
+        //The worker is gone and this is the render thread, nothing draws the preview right now
+        adoptDecodedPyramids(*result);
+        audio = std::move(result);
+    }
+    result.reset();
+    opened = nullptr;
+    return true;
+}
+
+LoadedAudio* AsyncLoader::preview() const
+{
+    if (!loading)
+        return nullptr;
+    return opened.load(std::memory_order_acquire);
+}
+
+//Odr-used by std::chrono::milliseconds, which takes it by reference
+const int TailFollower::pollMilliseconds;
+
+int TailFollower::start(const LoadedAudio& audio)
+{
+    stop();
+    if (audio.overview_only || !audio.overview_ready)
+    {
+        std::cout << "ERROR: Only files loaded into memory can be followed." << std::endl;
+        return -1;
+    }
+    if (reader.open(audio.file_name) != 0)
+        return -1;
+    long long mtime;
+    fileStamp(audio.file_name, file_size, mtime);
+    last_poll = std::chrono::steady_clock::time_point();
+    return 0;
+}
+
+void TailFollower::stop()
+{
+    reader.close();
+    file_size = 0;
+}
+
+size_t TailFollower::update(LoadedAudio& audio)
+{
+    if (!isFollowing())
+        return 0;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - last_poll < std::chrono::milliseconds(pollMilliseconds))
+        return 0;
+    last_poll = now;
+
+    //A stat() is far cheaper than mapping the file again, so only remap once it has grown
+    unsigned long long size;
+    long long mtime;
+    if (!fileStamp(audio.file_name, size, mtime))
+    {
+        std::cout << "ERROR: " << audio.file_name << " disappeared, no longer following it." << std::endl;
+        stop();
+        return 0;
+    }
+    if (size == file_size)
+        return 0;
+    file_size = size;
+
+    const size_t oldFrames = audio.samples.frameCount();
+    const size_t frameCount = reader.refresh();
+    if (!reader.isOpen())
+    {
+        stop();
+        return 0;
+    }
+    if (frameCount <= oldFrames)
+        return 0;
+
+    //Same limit as loading, past it the file would have been opened as an overview only
+    const int channelCount = reader.channelCount();
+    const PcmFormat storedFormat = audio.samples.format();
+    const size_t storedWidth = pcmBytesPerSample(storedFormat);
+    if (static_cast<unsigned long long>(frameCount) * channelCount * storedWidth > decodedBudgetBytes ||
+        !audio.samples.resize(frameCount))
+    {
+        std::cout << "ERROR: " << audio.file_name << " no longer fits in memory, no longer following it." << std::endl;
+        stop();
+        return 0;
+    }
+
+    //Decode only the appended frames, a slice at a time so the float scratch of compact stores stays small
+    const size_t sliceFrames = 1 << 16;
+    const bool floatStore = storedFormat == PcmFormat::Float32;
+    std::vector<float*> channels(channelCount);
+    std::vector<unsigned char*> rawChannels(channelCount);
+    std::vector<float> scratch(floatStore ? 0 : sliceFrames * channelCount);
+    const ClipRange clip = clipRange(reader.getFormat());
+    audio.wave.channel_stats.resize(channelCount);
+    for (size_t first = oldFrames; first < frameCount; first += sliceFrames)
+    {
+        size_t count = std::min(sliceFrames, frameCount - first);
+        for (int c = 0; c < channelCount; c++)
+            channels[c] = floatStore ? audio.samples.channel(c) + first : scratch.data() + sliceFrames * c;
+        if (floatStore)
+        {
+            reader.readFramesAt(first, channels.data(), count);
+        }
+        else
+        {
+            for (int c = 0; c < channelCount; c++)
+                rawChannels[c] = audio.samples.channelBytes(c) + first * storedWidth;
+            reader.splitFramesAt(first, rawChannels.data(), count);
+            for (int c = 0; c < channelCount; c++)
+                audio.samples.toFloat(c, first, count, channels[c]);
+        }
+        for (int c = 0; c < channelCount; c++)
+        {
+            audio.lods[c].extend(channels[c], count);
+            accumulateStats(channels[c], count, clip, audio.wave.channel_stats[c]);
+        }
+    }
+    setMaxAmplitude(audio.wave);
+    audio.data_version = nextDataVersion();
+
+    audio.wave.subchunk2_size = reader.getWave().subchunk2_size;
+    audio.wave.number_of_samples = frameCount;
+    audio.wave.duration = reader.getWave().duration;
+    return frameCount - oldFrames;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "wave.h"
+#include "waveform_lod.h"
+#include "sample_store.h"
+#include "wave_reader.h"
+#include "page_cache.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Everything produced by one load. The worker thread fills a private instance, the render thread only ever sees
+//a finished one.
+struct LoadedAudio {
+    std::string file_name;
+    Wave wave;
+
+    //Decoded samples, one planar channel per channel in the file. Left empty when overview_only is set. With
+    //compact_samples they keep the width of the file instead of being converted to float.
+    SampleStore samples;
+    bool overview_only = false;
+    bool compact_samples = false;
+
+    //Files loaded as an overview only stay open, their samples are decoded a page at a time when the view
+    //needs more detail than the pyramid holds
+    std::unique_ptr<WaveReader> reader;
+    std::unique_ptr<PageCache> pages;
+
+    //Min/max pyramid for each channel, built right after decoding or read from the file's peak file
+    std::vector<WaveformLod> lods;
+    //Set once lods is complete. Until then only wave and pages may be used (see AsyncLoader::preview()).
+    std::atomic<bool> overview_ready{ false };
+    //Set once the samples are decoded. Until then they may not be read, even when overview_ready is set.
+    std::atomic<bool> samples_ready{ false };
+
+    //Full pyramids built by the decode pass of a file whose overview came from its peak file (which only keeps
+    //the coarse levels). lods is drawn meanwhile, adoptDecodedPyramids() swaps them in.
+    std::vector<WaveformLod> decoded_lods;
+
+    //How much more growing one vector per channel with push_back would have peaked at than the exact-size
+    //channels, both at the sample width the store uses (compact storage saves memory on its own)
+    size_t preallocation_saved_bytes = 0;
+
+    //Unique to this load and changed whenever samples are appended, so geometry built from the samples can tell
+    //when it is stale
+    unsigned long long data_version = 0;
+};
+
+//Choices made before a file is loaded
+struct LoadOptions {
+    //Keep samples at their native width (int16, packed int24, ...) instead of float. Halves the memory of
+    //16-bit files, samples are converted where they are drawn.
+    bool compact_samples = false;
+    //Most memory the page cache of an overview-only file may hold decoded pages in
+    size_t page_cache_budget = PageCache::defaultBudgetBytes;
+};
+
+//Progress and cancellation shared between a loading thread and the UI
+struct LoadProgress {
+    std::atomic<unsigned long long> bytes_decoded{ 0 };
+    std::atomic<unsigned long long> bytes_total{ 0 };
+    std::atomic<bool> cancel{ false };
+};
+
+//Read the file by bytes to extract data from the .wav file. Returns 0 on success and -1 on failure or when
+//progress->cancel was raised. "progress" may be nullptr. Same as openFile() followed by buildOverview().
+int readFile(const std::string& fileName, LoadedAudio& audio, LoadProgress* progress = nullptr,
+             const LoadOptions& options = LoadOptions());
+
+//First half of readFile(): parse the header and decide whether the file fits in memory. Fast, it does not touch
+//the samples. Files that do not fit get their reader and page cache here. Every file gets its pyramids here if a
+//current peak file exists.
+int openFile(const std::string& fileName, LoadedAudio& audio, const LoadOptions& options = LoadOptions());
+
+//Second half of readFile(): decode the samples (unless overview_only) and build the pyramids, then save them to a
+//peak file so the next open can show the overview at once. Overview-only files with a peak file skip this. Files
+//decoded into memory build their full pyramids into decoded_lods when lods came from the peak file.
+int buildOverview(LoadedAudio& audio, LoadProgress* progress = nullptr);
+
+//Swap the pyramids buildOverview() put in decoded_lods into lods. Nothing may be drawing "audio" meanwhile.
+void adoptDecodedPyramids(LoadedAudio& audio);
+
+//Min/max columns of frames [start, end) of "channel", from whichever source has the detail needed: the pyramid,
+//the decoded samples or, for overview-only files, the page cache. Render thread only.
+size_t queryColumns(LoadedAudio& audio, int channel, size_t start, size_t end, size_t columns,
+                    std::vector<float>& out_min, std::vector<float>& out_max);
+
+//Runs readFile() on a worker thread so the UI keeps drawing while large files decode
+class AsyncLoader {
+public:
+    AsyncLoader() = default;
+    ~AsyncLoader();
+
+    AsyncLoader(const AsyncLoader&) = delete;
+    AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+    void start(const std::string& fileName, const LoadOptions& options = LoadOptions());
+    void cancel();
+
+    bool isLoading() const { return loading; }
+    //Fraction of the data chunk decoded so far, 0 to 1
+    float progress() const;
+    const std::string& fileName() const { return file_name; }
+
+    //Call once per frame. When the worker has finished, joins it, hands over the loaded audio (only on success)
+    //and returns true with readFile()'s result in "status".
+    bool poll(std::unique_ptr<LoadedAudio>& audio, int& status);
+
+    //Overview-only files can be shown from their page cache while the pyramid is still building, and files with
+    //a peak file from its pyramids while their samples decode. Returns the audio being loaded once its header is
+    //parsed, nullptr otherwise. Valid until the next poll().
+    LoadedAudio* preview() const;
+
+private:
+    std::thread worker;
+    LoadProgress state;
+    std::atomic<bool> finished{ false };
+    bool loading = false;
+
+    //Set by the worker once a file that can be previewed has been opened
+    std::atomic<LoadedAudio*> opened{ nullptr };
+
+    //Written by the worker before it sets "finished"
+    std::unique_ptr<LoadedAudio> result;
+    int result_status = -1;
+
+    std::string file_name;
+};
+
+//Follow mode for files that are still being recorded. Polls the file from the render thread and, once it has grown,
+//decodes only the frames appended since the last poll into the sample store and extends the pyramids with them,
+//so each update costs what was added rather than what the file holds.
+class TailFollower {
+public:
+    //Check for new frames at most this often
+    static const int pollMilliseconds = 100;
+
+    //Start following the file "audio" was loaded from. Returns 0 on success and -1 if it cannot be opened again
+    //or was loaded as an overview only (its samples are not kept in memory).
+    int start(const LoadedAudio& audio);
+    void stop();
+    bool isFollowing() const { return reader.isOpen(); }
+
+    //Call once per frame with the audio passed to start(). Returns the number of frames appended, 0 when the file
+    //has not grown or the poll interval has not passed yet. Stops following if the file disappears or no longer
+    //fits in memory.
+    size_t update(LoadedAudio& audio);
+
+private:
+    WaveReader reader;
+    unsigned long long file_size = 0;
+    std::chrono::steady_clock::time_point last_poll;
+};
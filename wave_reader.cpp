@@ -0,0 +1,256 @@
+#include "wave_reader.h"
+#include "riff.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const unsigned short waveFormatPcm = 0x0001;
+static const unsigned short waveFormatIeeeFloat = 0x0003;
+static const unsigned short waveFormatExtensible = 0xFFFE;
+
+//Every layout the decode kernels handle, keyed by format tag (taken from the SubFormat GUID for
+//WAVE_FORMAT_EXTENSIBLE) and container bits. The channel count then picks the mono, stereo or generic kernel
+//inside decodeInterleaved().
+struct DecoderEntry {
+    unsigned short format_tag;
+    short bits_per_sample;
+    PcmFormat format;
+};
+
+static const DecoderEntry decoderTable[] = {
+    { waveFormatPcm, 8, PcmFormat::UInt8 },
+    { waveFormatPcm, 16, PcmFormat::Int16 },
+    { waveFormatPcm, 24, PcmFormat::Int24 },
+    { waveFormatPcm, 32, PcmFormat::Int32 },
+    { waveFormatIeeeFloat, 32, PcmFormat::Float32 },
+    { waveFormatIeeeFloat, 64, PcmFormat::Float64 },
+};
+
+static bool findDecoder(short formatTag, short bitsPerSample, PcmFormat& format)
+{
+    for (const DecoderEntry& entry : decoderTable)
+    {
+        if (entry.format_tag == static_cast<unsigned short>(formatTag) && entry.bits_per_sample == bitsPerSample)
+        {
+            format = entry.format;
+            return true;
+        }
+    }
+    return false;
+}
+
+//KSDATAFORMAT_SUBTYPE_* GUIDs are a format tag followed by the same 14 bytes,
+//{xxxxxxxx-0000-0010-8000-00aa00389b71}. Anything else is a sub-format we cannot decode.
+static bool readSubFormat(const ByteSpan& bytes, size_t offset, short& formatTag)
+{
+    static const unsigned char baseGuid[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+                                                0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+    if (offset + 16 > bytes.size || std::memcmp(bytes.data + offset + 2, baseGuid, sizeof(baseGuid)) != 0)
+        return false;
+    formatTag = bytes.read<short>(offset);
+    return true;
+}
+
+int WaveReader::open(const std::string& fileName, MapAccess access)
+{
+    close();
+
+    //Map the Wav file, every read below goes straight to the mapped pages
+    if (!file.open(fileName, access))
+    {
+        std::cerr << "Error: Unable to open the file: " << fileName << std::endl;
+        return -1;
+    }
+    file_name = fileName;
+    map_access = access;
+    ByteSpan bytes = file.bytes();
+
+    //GET HEADER INFO
+    //Build an index of every top-level chunk by hopping from one chunk header to the next
+    RiffHeader header;
+    if (!parseRiffChunks(bytes, header, wave.chunks) || header.form != "WAVE")
+    {
+        std::cout << "ERROR: " << fileName << " is not a RIFF/RF64/BW64 WAVE file." << std::endl;
+        close();
+        return -1;
+    }
+    wave.chunk_id = header.container;
+    wave.format = header.form;
+
+    //Gather "fmt" sub-chunk info
+    const RiffChunk* fmtChunk = findChunk(wave.chunks, "fmt ");
+    if (fmtChunk == nullptr || fmtChunk->size < 16 || fmtChunk->payloadOffset() + 16 > bytes.size)
+    {
+        std::cout << "ERROR: " << fileName << " has no valid fmt chunk." << std::endl;
+        close();
+        return -1;
+    }
+    size_t fmtPos = static_cast<size_t>(fmtChunk->payloadOffset());
+    wave.subchunk1_id = fmtChunk->id;
+    wave.subchunk1_size = static_cast<int>(fmtChunk->size);
+    wave.audio_format = bytes.read<short>(fmtPos);
+    wave.num_channels = bytes.read<short>(fmtPos + 2);
+    wave.sample_rate = bytes.read<int>(fmtPos + 4);
+    wave.byte_rate = bytes.read<int>(fmtPos + 8);
+    wave.block_align = bytes.read<short>(fmtPos + 12);
+    wave.bits_per_sample = bytes.read<short>(fmtPos + 14);
+
+    //The size of each sample in bytes if wave.sample_size = 4, sample size is 4, channel 1 size = 2, channel 2 size = 2
+    wave.sample_size = (wave.bits_per_sample / 8) * wave.num_channels;
+    if (wave.block_align <= 0)
+    {
+        close();
+        return -1;
+    }
+
+    //Some files carry an empty "data" chunk ahead of the real one (see audio2.wav), so take the first data chunk
+    //that actually holds samples
+    const RiffChunk* dataChunk = findChunk(wave.chunks, "data", true);
+    unsigned long long dataSize = (dataChunk != nullptr) ? dataChunk->size : 0;
+
+    //A recorder that is still writing (or crashed) leaves the size at 0. With no other data chunk, the samples of
+    //the last empty one run to the end of the file.
+    if (dataChunk == nullptr)
+    {
+        for (const RiffChunk& chunk : wave.chunks)
+        {
+            if (chunk.id == "data")
+                dataChunk = &chunk;
+        }
+        if (dataChunk != nullptr)
+            dataSize = bytes.size - std::min<unsigned long long>(bytes.size, dataChunk->payloadOffset());
+    }
+    if (dataChunk == nullptr || dataSize == 0)
+    {
+        std::cout << "ERROR: Read " << wave.chunks.size() << " chunks. Valid data chunk cannot be found!" << std::endl;
+        std::cout << "ERROR: " << fileName << " cannot be read." << std::endl;
+        close();
+        return -1;
+    }
+    wave.subchunk2_id = dataChunk->id;
+    wave.subchunk2_size = dataChunk->size;
+
+    //Never read past the end of the file even if the header claims more
+    unsigned long long dataOffset = std::min<unsigned long long>(dataChunk->payloadOffset(), bytes.size);
+    data = bytes.subspan(static_cast<size_t>(dataOffset), static_cast<size_t>(std::min<unsigned long long>(dataSize, bytes.size - dataOffset)));
+    if (data.size < dataSize)
+        std::cout << "WARNING: data chunk claims " << dataSize << " bytes but only " << data.size << " exist." << std::endl;
+    frame_count = data.size / wave.block_align;
+
+    wave.number_of_samples = frame_count;
+    wave.duration = (float)wave.number_of_samples / (float)wave.sample_rate;
+
+    //Pick the decoder from what the samples are, not from how many bytes a frame takes
+    if (wave.num_channels <= 0)
+    {
+        std::cout << "ERROR: " << fileName << " has no channels." << std::endl;
+        close();
+        return -1;
+    }
+    short formatTag = wave.audio_format;
+    if (static_cast<unsigned short>(wave.audio_format) == waveFormatExtensible)
+    {
+        //cbSize (2), wValidBitsPerSample (2), dwChannelMask (4), SubFormat GUID (16)
+        if (fmtChunk->size < 40 || bytes.read<unsigned short>(fmtPos + 16) < 22 || !readSubFormat(bytes, fmtPos + 24, wave.sub_format))
+        {
+            std::cout << "ERROR: " << fileName << " has an unknown WAVE_FORMAT_EXTENSIBLE sub-format." << std::endl;
+            close();
+            return -1;
+        }
+        wave.valid_bits_per_sample = bytes.read<short>(fmtPos + 18);
+        wave.channel_mask = bytes.read<int>(fmtPos + 20);
+        formatTag = wave.sub_format;
+    }
+    if (!findDecoder(formatTag, wave.bits_per_sample, format) ||
+        static_cast<size_t>(wave.block_align) != pcmBytesPerSample(format) * wave.num_channels)
+    {
+        std::cout << "ERROR: Audio format " << formatTag << " with " << wave.bits_per_sample << " bits and a block align of "
+                  << wave.block_align << " is not supported." << std::endl;
+        close();
+        return -1;
+    }
+
+    return 0;
+}
+
+size_t WaveReader::refresh()
+{
+    if (!isOpen())
+        return 0;
+
+    //The data chunk keeps its place, only its end moves
+    unsigned long long dataOffset = static_cast<unsigned long long>(data.data - file.data());
+    std::string fileName = file_name;
+    MapAccess access = map_access;
+    file.close();
+    if (!file.open(fileName, access))
+    {
+        std::cout << "ERROR: " << fileName << " can no longer be opened." << std::endl;
+        close();
+        return 0;
+    }
+    ByteSpan bytes = file.bytes();
+
+    //Any chunk found after the data chunk means the recording has finished and its size field can be trusted
+    RiffHeader header;
+    std::vector<RiffChunk> chunks;
+    parseRiffChunks(bytes, header, chunks);
+    unsigned long long dataSize = bytes.size - std::min<unsigned long long>(bytes.size, dataOffset);
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        if (chunks[i].payloadOffset() == dataOffset && i + 1 < chunks.size())
+            dataSize = std::min(dataSize, chunks[i].size);
+    }
+    wave.chunks = chunks;
+    wave.subchunk2_size = dataSize;
+
+    data = bytes.subspan(static_cast<size_t>(dataOffset), static_cast<size_t>(dataSize));
+    frame_count = data.size / wave.block_align;
+    position = std::min(position, frame_count);
+    wave.number_of_samples = frame_count;
+    wave.duration = (float)wave.number_of_samples / (float)wave.sample_rate;
+    return frame_count;
+}
+
+void WaveReader::close()
+{
+    file.close();
+    file_name.clear();
+    wave.reset();
+    data = ByteSpan();
+    format = PcmFormat::Int16;
+    frame_count = 0;
+    position = 0;
+}
+
+bool WaveReader::seekFrame(size_t frame)
+{
+    position = std::min(frame, frame_count);
+    return frame <= frame_count;
+}
+
+size_t WaveReader::readFrames(float* const* out, size_t frames)
+{
+    size_t count = readFramesAt(position, out, frames);
+    position += count;
+    return count;
+}
+
+size_t WaveReader::readFramesAt(size_t first, float* const* out, size_t frames) const
+{
+    if (first >= frame_count)
+        return 0;
+    size_t count = std::min(frames, frame_count - first);
+    decodeInterleaved(format, data.data + first * static_cast<size_t>(wave.block_align), count, wave.num_channels, out);
+    return count;
+}
+
+size_t WaveReader::splitFramesAt(size_t first, unsigned char* const* out, size_t frames) const
+{
+    if (first >= frame_count)
+        return 0;
+    size_t count = std::min(frames, frame_count - first);
+    splitInterleaved(format, data.data + first * static_cast<size_t>(wave.block_align), count, wave.num_channels, out);
+    return count;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "wave.h"
+#include "mapped_file.h"
+#include "pcm_decode.h"
+#include <string>
+
+//Pull-style reader over the data chunk of a WAV file. open() only parses the header, samples are decoded on
+//demand into buffers owned by the caller, so the working set is whatever the caller asks for rather than the size
+//of the file. The file is mapped, not read, which leaves paging of the raw bytes to the OS.
+class WaveReader {
+public:
+    WaveReader() = default;
+
+    WaveReader(const WaveReader&) = delete;
+    WaveReader& operator=(const WaveReader&) = delete;
+
+    //Map "fileName" and parse its RIFF/RF64/BW64 header. Returns 0 on success and -1 if the file cannot be
+    //opened or is not a WAV file this reader can decode. "access" should match how the samples will be read.
+    int open(const std::string& fileName, MapAccess access = MapAccess::Sequential);
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+    const Wave& getWave() const { return wave; }
+    PcmFormat getFormat() const { return format; }
+    int channelCount() const { return wave.num_channels; }
+    size_t frameCount() const { return frame_count; }
+    //Every byte of the file ahead of the samples (RIFF header, fmt and any other leading chunks)
+    ByteSpan headerBytes() const { return file.bytes().subspan(0, static_cast<size_t>(data.data - file.data())); }
+
+    //For files that are still being written: map the file again at its current length and walk its chunks once
+    //more. While the data chunk is the last one, its samples run to the end of the file whatever its size field
+    //says (recorders often leave it at 0 or patch it only now and then). The fmt chunk is not parsed again.
+    //Returns the new frameCount(). The reader is closed if the file can no longer be opened.
+    size_t refresh();
+
+    //Current read position in frames
+    size_t tell() const { return position; }
+    //Move the read position, clamped to frameCount(). Returns false if "frame" was past the end.
+    bool seekFrame(size_t frame);
+
+    //Decode up to "frames" frames at the read position into out[c] (one planar buffer per channel, each with
+    //room for "frames" floats) and advance past them. Returns the number of frames read, 0 at the end.
+    size_t readFrames(float* const* out, size_t frames);
+
+    //Same as readFrames() but from "first" without touching the read position. Safe to call from several
+    //threads at once.
+    size_t readFramesAt(size_t first, float* const* out, size_t frames) const;
+
+    //Like readFramesAt() but without converting, out[c] receives the raw samples at the width of getFormat()
+    size_t splitFramesAt(size_t first, unsigned char* const* out, size_t frames) const;
+
+private:
+    std::string file_name;
+    MapAccess map_access = MapAccess::Sequential;
+    MappedFile file;
+    Wave wave;
+    ByteSpan data;
+    PcmFormat format = PcmFormat::Int16;
+    size_t frame_count = 0;
+    size_t position = 0;
+};
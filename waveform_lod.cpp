@@ -0,0 +1,273 @@
+#include "waveform_lod.h"
+
+#include <algorithm>
+#include <cmath>
+
+void WaveformLod::clear()
+{
+    sample_count = 0;
+    levels.clear();
+}
+
+void WaveformLod::build(const float* samples, size_t count)
+{
+    reset(count);
+    if (samples != nullptr)
+        summarize(0, samples, count);
+    finish();
+}
+
+void WaveformLod::reset(size_t count, size_t bucketSize)
+{
+    clear();
+    sample_count = count;
+    if (count == 0 || bucketSize == 0)
+        return;
+
+    //Level 0: summarizes the raw samples
+    LodLevel base;
+    base.bucket_size = bucketSize;
+    size_t bucketCount = (count + bucketSize - 1) / bucketSize;
+    base.min_values.resize(bucketCount);
+    base.max_values.resize(bucketCount);
+    base.rms_values.resize(bucketCount);
+    levels.push_back(std::move(base));
+}
+
+void WaveformLod::summarize(size_t first, const float* samples, size_t n)
+{
+    if (levels.empty() || n == 0)
+        return;
+
+    LodLevel& base = levels[0];
+    size_t bucketSize = base.bucket_size;
+    size_t end = std::min(first + n, sample_count);
+    for (size_t bucketStart = first; bucketStart < end; bucketStart += bucketSize)
+    {
+        const float* bucket = samples + (bucketStart - first);
+        size_t bucketLength = std::min(end - bucketStart, bucketSize);
+        float lo = bucket[0];
+        float hi = bucket[0];
+        double squares = 0.0;
+        for (size_t i = 0; i < bucketLength; i++)
+        {
+            lo = std::min(lo, bucket[i]);
+            hi = std::max(hi, bucket[i]);
+            squares += static_cast<double>(bucket[i]) * bucket[i];
+        }
+        base.min_values[bucketStart / bucketSize] = lo;
+        base.max_values[bucketStart / bucketSize] = hi;
+        base.rms_values[bucketStart / bucketSize] = static_cast<float>(std::sqrt(squares / bucketLength));
+    }
+}
+
+void WaveformLod::finish()
+{
+    if (levels.empty())
+        return;
+    levels.resize(1);
+
+    //Every following level merges branchFactor buckets of the previous one until a single bucket remains
+    while (levels.back().min_values.size() > 1)
+    {
+        LodLevel next;
+        next.bucket_size = levels.back().bucket_size * branchFactor;
+        levels.push_back(std::move(next));
+        mergeLevel(levels.size() - 1, 0);
+    }
+}
+
+void WaveformLod::extend(const float* samples, size_t n)
+{
+    if (n == 0)
+        return;
+    if (levels.empty())
+    {
+        build(samples, n);
+        return;
+    }
+
+    LodLevel& base = levels[0];
+    const size_t bucketSize = base.bucket_size;
+    const size_t oldCount = sample_count;
+    sample_count += n;
+
+    //Top up the last bucket if it was short. Its min and max merge directly, its RMS through the sum of squares
+    //it stood for, so the samples it already covered are not needed again.
+    size_t consumed = 0;
+    size_t partial = oldCount % bucketSize;
+    if (partial != 0)
+    {
+        size_t b = oldCount / bucketSize;
+        consumed = std::min(bucketSize - partial, n);
+        double squares = static_cast<double>(base.rms_values[b]) * base.rms_values[b] * partial;
+        for (size_t i = 0; i < consumed; i++)
+        {
+            base.min_values[b] = std::min(base.min_values[b], samples[i]);
+            base.max_values[b] = std::max(base.max_values[b], samples[i]);
+            squares += static_cast<double>(samples[i]) * samples[i];
+        }
+        base.rms_values[b] = static_cast<float>(std::sqrt(squares / (partial + consumed)));
+    }
+
+    //Whole new buckets, "first" is on a bucket boundary after the top up
+    size_t bucketCount = (sample_count + bucketSize - 1) / bucketSize;
+    base.min_values.resize(bucketCount);
+    base.max_values.resize(bucketCount);
+    base.rms_values.resize(bucketCount);
+    summarize(oldCount + consumed, samples + consumed, n - consumed);
+
+    //Only the buckets above the changed ones are merged again, adding levels while the top has more than one
+    size_t dirty = oldCount / bucketSize;
+    for (size_t l = 1; l < levels.size() || levels.back().min_values.size() > 1; l++)
+    {
+        if (l == levels.size())
+        {
+            LodLevel next;
+            next.bucket_size = levels.back().bucket_size * branchFactor;
+            levels.push_back(std::move(next));
+        }
+        dirty /= branchFactor;
+        mergeLevel(l, dirty);
+    }
+}
+
+void WaveformLod::mergeLevel(size_t l, size_t first)
+{
+    const LodLevel& below = levels[l - 1];
+    LodLevel& level = levels[l];
+    size_t belowCount = below.min_values.size();
+    size_t bucketCount = (belowCount + branchFactor - 1) / branchFactor;
+    first = std::min(first, level.min_values.size());
+    level.min_values.resize(bucketCount);
+    level.max_values.resize(bucketCount);
+    level.rms_values.resize(bucketCount);
+    for (size_t b = first; b < bucketCount; b++)
+    {
+        size_t begin = b * branchFactor;
+        size_t last = std::min(begin + branchFactor, belowCount);
+        level.min_values[b] = *std::min_element(below.min_values.begin() + begin, below.min_values.begin() + last);
+        level.max_values[b] = *std::max_element(below.max_values.begin() + begin, below.max_values.begin() + last);
+
+        //Mean of the squares, weighted by how many samples each bucket below covers (the last one may be short)
+        double squares = 0.0;
+        size_t covered = 0;
+        for (size_t i = begin; i < last; i++)
+        {
+            size_t length = std::min(below.bucket_size, sample_count - i * below.bucket_size);
+            squares += static_cast<double>(below.rms_values[i]) * below.rms_values[i] * length;
+            covered += length;
+        }
+        level.rms_values[b] = static_cast<float>(std::sqrt(squares / covered));
+    }
+}
+
+bool WaveformLod::assign(size_t count, std::vector<LodLevel>&& built)
+{
+    clear();
+    for (size_t l = 0; l < built.size(); l++)
+    {
+        const LodLevel& level = built[l];
+        size_t expected = (level.bucket_size > 0) ? (count + level.bucket_size - 1) / level.bucket_size : 0;
+        bool chained = (l == 0) || level.bucket_size == built[l - 1].bucket_size * branchFactor;
+        if (expected == 0 || !chained || level.min_values.size() != expected || level.max_values.size() != expected ||
+            level.rms_values.size() != expected)
+            return false;
+    }
+    if (built.empty() || built.back().min_values.size() != 1)
+        return false;
+
+    sample_count = count;
+    levels = std::move(built);
+    return true;
+}
+
+float WaveformLod::maxValue() const
+{
+    if (levels.empty())
+        return 0.0f;
+    return levels.back().max_values[0];
+}
+
+size_t WaveformLod::query(const float* samples, size_t start, size_t end, size_t columns,
+                          std::vector<float>& out_min, std::vector<float>& out_max) const
+{
+    out_min.clear();
+    out_max.clear();
+    end = std::min(end, sample_count);
+    if (start >= end || columns == 0)
+        return 0;
+
+    size_t count = end - start;
+
+    //Zoomed in past one sample per column, hand back the samples themselves
+    if (count <= columns && samples != nullptr)
+        return reduce(samples + start, count, columns, out_min, out_max);
+
+    //Pick the coarsest level whose buckets still fit inside a single column. Raw samples are used when even
+    //level 0 is too coarse.
+    columns = std::min(columns, count);
+    double samplesPerColumn = static_cast<double>(count) / static_cast<double>(columns);
+    const LodLevel* level = nullptr;
+    for (const LodLevel& candidate : levels)
+    {
+        if (static_cast<double>(candidate.bucket_size) <= samplesPerColumn)
+            level = &candidate;
+    }
+    if (level == nullptr && samples != nullptr)
+        return reduce(samples + start, count, columns, out_min, out_max);
+    if (level == nullptr)
+    {
+        if (levels.empty())
+            return 0;
+        level = &levels[0];
+    }
+
+    out_min.resize(columns);
+    out_max.resize(columns);
+    for (size_t c = 0; c < columns; c++)
+    {
+        size_t first = start + static_cast<size_t>(c * samplesPerColumn);
+        size_t last = std::min(start + static_cast<size_t>((c + 1) * samplesPerColumn), end);
+        if (last <= first)
+            last = first + 1;
+
+        //Buckets straddling the column edges are included whole so that no peak can fall between columns
+        size_t firstBucket = first / level->bucket_size;
+        size_t lastBucket = (last - 1) / level->bucket_size + 1;
+        out_min[c] = *std::min_element(level->min_values.begin() + firstBucket, level->min_values.begin() + lastBucket);
+        out_max[c] = *std::max_element(level->max_values.begin() + firstBucket, level->max_values.begin() + lastBucket);
+    }
+    return columns;
+}
+
+size_t WaveformLod::reduce(const float* samples, size_t count, size_t columns,
+                           std::vector<float>& out_min, std::vector<float>& out_max)
+{
+    out_min.clear();
+    out_max.clear();
+    if (count == 0 || columns == 0)
+        return 0;
+
+    //Every sample gets its own column
+    if (count <= columns)
+    {
+        out_min.assign(samples, samples + count);
+        out_max.assign(samples, samples + count);
+        return count;
+    }
+
+    double samplesPerColumn = static_cast<double>(count) / static_cast<double>(columns);
+    out_min.resize(columns);
+    out_max.resize(columns);
+    for (size_t c = 0; c < columns; c++)
+    {
+        size_t first = static_cast<size_t>(c * samplesPerColumn);
+        size_t last = std::min(static_cast<size_t>((c + 1) * samplesPerColumn), count);
+        if (last <= first)
+            last = first + 1;
+        out_min[c] = *std::min_element(samples + first, samples + last);
+        out_max[c] = *std::max_element(samples + first, samples + last);
+    }
+    return columns;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+//Multi-resolution min/max/RMS summary of a single channel. Level 0 summarizes the raw samples in buckets of
+//baseBucketSize (or a coarser size picked at reset()), every following level merges branchFactor buckets of the
+//level below it. Built once after a file is loaded, then queried every frame for the visible range so drawing
+//cost depends on the window width rather than on the number of samples.
+
+struct LodLevel {
+    size_t bucket_size = 0;             //Number of raw samples summarized by one bucket
+    std::vector<float> min_values;
+    std::vector<float> max_values;
+    std::vector<float> rms_values;
+};
+
+class WaveformLod {
+public:
+    static const size_t baseBucketSize = 16;
+    static const size_t branchFactor = 4;
+
+    //Build every level from the raw samples of one channel
+    void build(const float* samples, size_t count);
+    void clear();
+
+    //Build in pieces, for when the samples are never held in one array: reset() sizes level 0 for "count"
+    //samples in buckets of "bucketSize", summarize() fills the level 0 buckets covering samples [first, first + n)
+    //and may run on several threads for disjoint ranges, finish() then builds the upper levels. "first" must be a
+    //multiple of the bucket size.
+    void reset(size_t count, size_t bucketSize = baseBucketSize);
+    void summarize(size_t first, const float* samples, size_t n);
+    void finish();
+
+    //Append samples [sampleCount(), sampleCount() + n) to a finished pyramid, for files that are still growing.
+    //Only the buckets the new samples fall into are touched, on every level, so the cost is proportional to "n".
+    void extend(const float* samples, size_t n);
+
+    //Take over complete levels built elsewhere (e.g. read from a peak file). Returns false, leaving the pyramid
+    //empty, if they do not describe "count" samples.
+    bool assign(size_t count, std::vector<LodLevel>&& built);
+
+    //Largest sample value in the channel
+    float maxValue() const;
+
+    //Reduce samples [start, end) to at most "columns" min/max pairs. When the range holds fewer samples than
+    //columns, every sample gets its own column (min == max). "samples" must be the array the pyramid was built
+    //from, it is only read when the range is too narrow for level 0. It may be nullptr when no raw samples are
+    //kept, level 0 is then used at every zoom. Returns the number of columns written.
+    size_t query(const float* samples, size_t start, size_t end, size_t columns,
+                 std::vector<float>& out_min, std::vector<float>& out_max) const;
+
+    //Reduce samples[0, count) to at most "columns" min/max pairs straight from the samples, without a pyramid.
+    //Columns are laid out exactly as in query().
+    static size_t reduce(const float* samples, size_t count, size_t columns,
+                         std::vector<float>& out_min, std::vector<float>& out_max);
+
+    size_t sampleCount() const { return sample_count; }
+    //Samples per bucket of the finest level, 0 when empty
+    size_t finestBucketSize() const { return levels.empty() ? 0 : levels[0].bucket_size; }
+    const std::vector<LodLevel>& getLevels() const { return levels; }
+
+private:
+    //(Re)compute the buckets of level l from index "first" on out of level l - 1, sizing it to match
+    void mergeLevel(size_t l, size_t first);
+
+    size_t sample_count = 0;
+    std::vector<LodLevel> levels;
+};